@@ -0,0 +1,36 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_ARDUINO_DEBUG_UTILS_H_
+#define TEST_ARDUINO_DEBUG_UTILS_H_
+
+/******************************************************************************
+   DEFINE
+ ******************************************************************************/
+
+#define DBG_NONE    -1
+#define DBG_ERROR    0
+#define DBG_WARNING  1
+#define DBG_INFO     2
+#define DBG_DEBUG    3
+#define DBG_VERBOSE  4
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class Arduino_DebugUtils
+{
+  public:
+    /* Messages are discarded, the format is still checked against the arguments */
+    void print(int const /* debug_level */, char const * /* fmt */, ...) __attribute__((format(printf, 3, 4))) { }
+};
+
+/******************************************************************************
+   GLOBAL VARIABLES
+ ******************************************************************************/
+
+static Arduino_DebugUtils Debug __attribute__((unused));
+
+#endif /* TEST_ARDUINO_DEBUG_UTILS_H_ */
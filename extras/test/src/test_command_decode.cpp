@@ -174,6 +174,7 @@ SCENARIO("Test the decoding of command messages") {
     THEN("The decode is successful") {
       REQUIRE(err == Decoder::Status::Complete);
       REQUIRE(command.lastValuesUpdateCmd.params.length == 13);
+      REQUIRE(command.lastValuesUpdateCmd.params.last_values == payload + 7);
       REQUIRE(command.lastValuesUpdateCmd.params.last_values[0] == (uint8_t)0x00);
       REQUIRE(command.lastValuesUpdateCmd.params.last_values[1] == (uint8_t)0x01);
       REQUIRE(command.lastValuesUpdateCmd.params.last_values[2] == (uint8_t)0x02);
@@ -189,7 +190,67 @@ SCENARIO("Test the decoding of command messages") {
       REQUIRE(command.lastValuesUpdateCmd.params.last_values[12] == (uint8_t)0x12);
       REQUIRE(command.c.id == LastValuesUpdateCmdId);
     }
-    free(command.lastValuesUpdateCmd.params.last_values);
+  }
+
+  /****************************************************************************/
+
+  WHEN("Decode a truncated LastValuesUpdateCmd message")
+  {
+    CommandDown command;
+
+    /* DA 00010600 81 4D 0001020304 # tag(67072) array(1) bytes(13), 8 bytes missing */
+    uint8_t const payload[] = {0xDA, 0x00, 0x01, 0x06, 0x00, 0x81, 0x4D, 0x00,
+                               0x01, 0x02, 0x03, 0x04};
+
+    size_t payload_length = sizeof(payload) / sizeof(uint8_t);
+    CBORMessageDecoder decoder;
+    Decoder::Status err =  decoder.decode((Message*)&command, payload, payload_length);
+
+    THEN("The decode is unsuccessful") {
+      REQUIRE(err == Decoder::Status::Error);
+    }
+  }
+
+  /****************************************************************************/
+
+  WHEN("Locate the last values of a LastValuesUpdateCmd message of which only the beginning is available")
+  {
+    /*
+      DA 00010600                        # tag(67072)
+        81                               # array(1)
+            59 0100                      # bytes(256)
+              0001...
+    */
+    uint8_t const payload[] = {0xDA, 0x00, 0x01, 0x06, 0x00, 0x81, 0x59, 0x01,
+                               0x00, 0x00, 0x01, 0x02};
+
+    size_t offset = 0, length = 0;
+    CBORMessageDecoder decoder;
+
+    THEN("The position and the length of the last values are returned") {
+      REQUIRE(decoder.findLastValues(payload, sizeof(payload), offset, length));
+      REQUIRE(offset == 9);
+      REQUIRE(length == 256);
+    }
+
+    THEN("The header of the last values must be available") {
+      REQUIRE_FALSE(decoder.findLastValues(payload, 8, offset, length));
+    }
+  }
+
+  /****************************************************************************/
+
+  WHEN("Locate the last values of another message")
+  {
+    /* DA 00010400 81 78 24 ... # tag(66560) array(1) text(36) */
+    uint8_t const payload[] = {0xDA, 0x00, 0x01, 0x04, 0x00, 0x81, 0x78, 0x24};
+
+    size_t offset = 0, length = 0;
+    CBORMessageDecoder decoder;
+
+    THEN("The message is rejected") {
+      REQUIRE_FALSE(decoder.findLastValues(payload, sizeof(payload), offset, length));
+    }
   }
 
   /****************************************************************************/
@@ -783,4 +844,56 @@ SCENARIO("Test the decoding of command messages") {
     }
   }
 
+  /****************************************************************************/
+
+  WHEN("Decode a message of a command sent by the device")
+  {
+    CommandDown command;
+
+    /*
+      DA 00010300                             # tag(66304)
+        81                                    # array(1)
+          78 24                               # text(36)
+            65343439343137342D623631312D346330352D386563302D393838613162613438393265
+    */
+    uint8_t const payload[] = {0xDA, 0x00, 0x01, 0x03, 0x00, 0x81, 0x78, 0x24,
+                               0x65, 0x34, 0x34, 0x39, 0x34, 0x31, 0x37, 0x34,
+                               0x2D, 0x62, 0x36, 0x31, 0x31, 0x2D, 0x34, 0x63,
+                               0x30, 0x35, 0x2D, 0x38, 0x65, 0x63, 0x30, 0x2D,
+                               0x39, 0x38, 0x38, 0x61, 0x31, 0x62, 0x61, 0x34,
+                               0x38, 0x39, 0x32, 0x65};
+
+    size_t payload_length = sizeof(payload) / sizeof(uint8_t);
+    CBORMessageDecoder decoder;
+    Decoder::Status err =  decoder.decode((Message*)&command, payload, payload_length);
+
+    THEN("The decode is unsuccessful - ThingBeginCmd is not supported") {
+      REQUIRE(err == Decoder::Status::Error);
+    }
+  }
+
+  /****************************************************************************/
+
+  WHEN("Look up the descriptors of the commands")
+  {
+    THEN("Every tag is mapped to its command id and back") {
+      CBORCommandTag const tags[] = {
+        CBOROtaBeginUp, CBORThingBeginCmd, CBORLastValuesBeginCmd, CBORDeviceBeginCmd, CBOROtaProgressCmdUp, CBORTimezoneCommandUp,
+        CBOROtaUpdateCmdDown, CBORThingUpdateCmd, CBORThingDetachCmd, CBORLastValuesUpdate, CBORTimezoneCommandDown
+      };
+      for (CBORCommandTag const tag : tags) {
+        CBORCommandDescriptor const * command = findCBORCommand(tag);
+        REQUIRE(command != nullptr);
+        REQUIRE(command->tag == tag);
+        REQUIRE(findCBORCommand(command->id) == command);
+        REQUIRE(toCBORCommandTag(toCommandId(tag)) == tag);
+      }
+    }
+
+    THEN("Commands without CBOR encoding are not found") {
+      REQUIRE(findCBORCommand(CommandId::PropertiesUpdateCmdId) == nullptr);
+      REQUIRE(toCommandId(CBORUnknownCmdTag) == CommandId::UnknownCmdId);
+      REQUIRE(toCBORCommandTag(CommandId::UnknownCmdId) == CBORUnknownCmdTag);
+    }
+  }
 }
@@ -10,6 +10,7 @@
 #include <catch2/catch_approx.hpp>
 
 #include <memory>
+#include <vector>
 
 #include <util/CBORTestUtil.h>
 
@@ -30,6 +31,37 @@
 
 using namespace Catch;
 
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static int update_callback_count = 0;
+
+static void countUpdateCallback()
+{
+  update_callback_count++;
+}
+
+static bool decodeInChunks(PropertyContainer & property_container, uint8_t const * payload, size_t const length, size_t const buffer_size, size_t const chunk_size)
+{
+  std::vector<uint8_t> buffer(buffer_size);
+  CBORDecoder decoder(property_container, buffer.data(), buffer.size());
+
+  for (size_t pos = 0; pos < length; ) {
+    size_t room = 0;
+    uint8_t * chunk = decoder.reserve(room);
+    size_t const chunk_length = std::min(std::min(room, chunk_size), length - pos);
+    if (chunk_length == 0)
+      return false;
+    memcpy(chunk, payload + pos, chunk_length);
+    pos += chunk_length;
+    if (!decoder.commit(chunk_length))
+      return false;
+  }
+
+  return decoder.isComplete();
+}
+
 /**************************************************************************************
    TEST CODE
  **************************************************************************************/
@@ -139,6 +171,28 @@ SCENARIO("Arduino Cloud Properties are decoded", "[ArduinoCloudThing::decode]")
 
   /************************************************************************************/
 
+  WHEN("A String property with a name and a value longer than 23 characters is changed via CBOR message")
+  {
+    PropertyContainer property_container;
+
+    CloudString str_test;
+    str_test = "test";
+    addPropertyToContainer(property_container, str_test, "test_with_a_long_property_name", Permission::ReadWrite);
+
+    /* [{0: "test_with_a_long_property_name", 3: "a value longer than 23 characters"}] */
+    std::string const name = "test_with_a_long_property_name";
+    std::string const value = "a value longer than 23 characters";
+    std::vector<uint8_t> payload = {0x81, 0xA2, 0x00, 0x78, static_cast<uint8_t>(name.size())};
+    payload.insert(payload.end(), name.begin(), name.end());
+    payload.insert(payload.end(), {0x03, 0x78, static_cast<uint8_t>(value.size())});
+    payload.insert(payload.end(), value.begin(), value.end());
+    CBORDecoder::decode(property_container, payload.data(), payload.size());
+
+    REQUIRE(str_test == "a value longer than 23 characters");
+  }
+
+  /************************************************************************************/
+
   WHEN("A Location property is changed via CBOR message")
   {
     PropertyContainer property_container;
@@ -180,6 +234,28 @@ SCENARIO("Arduino Cloud Properties are decoded", "[ArduinoCloudThing::decode]")
 
   /************************************************************************************/
 
+  WHEN("A Color property is changed via CBOR message with the attributes in a different order")
+  {
+    PropertyContainer property_container;
+
+    CloudColor color_test = CloudColor(0.0, 0.0, 0.0);
+
+    addPropertyToContainer(property_container, color_test, "test", Permission::ReadWrite);
+
+    /* [{0: "test:bri", 2: 3.0},{0: "test:sat", 2: 2.0},{0: "test:hue", 2: 1.0}] */
+    uint8_t const payload[] = {0x83, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x62, 0x72, 0x69, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00,
+                                     0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x73, 0x61, 0x74, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00,
+                                     0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x68, 0x75, 0x65, 0x02, 0xFA, 0x3F, 0x80, 0x00, 0x00 };
+    CBORDecoder::decode(property_container, payload, sizeof(payload) / sizeof(uint8_t));
+
+    Color value_color_test = color_test.getValue();
+    REQUIRE(value_color_test.hue == 1.0f);
+    REQUIRE(value_color_test.sat == 2.0f);
+    REQUIRE(value_color_test.bri == 3.0f);
+  }
+
+  /************************************************************************************/
+
   WHEN("A Color property is changed via CBOR message - light payload")
   {
     /*An integer identifier has been encoded instead of the name of the property in order to have a shorter payload*/
@@ -205,6 +281,32 @@ SCENARIO("Arduino Cloud Properties are decoded", "[ArduinoCloudThing::decode]")
 
   /************************************************************************************/
 
+  WHEN("A Color property with an identifier exceeding 8 bit is changed via CBOR message - light payload")
+  {
+    PropertyContainer property_container;
+
+    CloudColor color_test = CloudColor(0.0, 0.0, 0.0);
+    CloudColor color_other = CloudColor(0.0, 0.0, 0.0);
+
+    /* Identifier 44 must not be mistaken for identifier 300 (= 256 + 44) */
+    addPropertyToContainer(property_container, color_test, "test", Permission::ReadWrite, 300);
+    addPropertyToContainer(property_container, color_other, "other", Permission::ReadWrite, 44);
+
+    /* [{0: 131372, 2: 2.0},{0: 196908, 2: 3.0},{0: 262444, 2: 4.0}] = 83 A2 00 1A 00 02 01 2C 02 FA 40 00 00 00 A2 00 1A 00 03 01 2C 02 FA 40 40 00 00 A2 00 1A 00 04 01 2C 02 FA 40 80 00 00 */
+    uint8_t const payload[] = {0x83, 0xA2, 0x00, 0x1A, 0x00, 0x02, 0x01, 0x2C, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x1A, 0x00, 0x03, 0x01, 0x2C, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xA2, 0x00, 0x1A, 0x00, 0x04, 0x01, 0x2C, 0x02, 0xFA, 0x40, 0x80, 0x00, 0x00 };
+    CBORDecoder::decode(property_container, payload, sizeof(payload) / sizeof(uint8_t));
+
+    Color value_color_test = color_test.getValue();
+    REQUIRE(value_color_test.hue == Approx(2.0));
+    REQUIRE(value_color_test.sat == Approx(3.0));
+    REQUIRE(value_color_test.bri == Approx(4.0));
+
+    Color value_color_other = color_other.getValue();
+    REQUIRE(value_color_other.hue == Approx(0.0));
+  }
+
+  /************************************************************************************/
+
   WHEN("A ColoredLight property is changed via CBOR message")
   {
     PropertyContainer property_container;
@@ -651,4 +753,158 @@ SCENARIO("Arduino Cloud Properties are decoded", "[ArduinoCloudThing::decode]")
   }
 
   /************************************************************************************/
+
+  WHEN("A payload is received in chunks")
+  {
+    PropertyContainer property_container;
+
+    CloudBool   bool_test = false;
+    CloudInt    int_test = 1;
+    CloudFloat  float_test = 2.0f;
+    CloudString str_test;
+    str_test = ("str_test");
+
+    addPropertyToContainer(property_container, bool_test,  "bool_test",  Permission::ReadWrite);
+    addPropertyToContainer(property_container, int_test,   "int_test",   Permission::ReadWrite);
+    addPropertyToContainer(property_container, float_test, "float_test", Permission::ReadWrite);
+    addPropertyToContainer(property_container, str_test,   "str_test",   Permission::ReadWrite);
+
+    /* [{0: "bool_test", 4: true}, {0: "int_test", 2: 10}, {0: "float_test", 2: 20.0}, {0: "str_test", 3: "hello arduino"}] */
+    uint8_t const payload[] = {0x84, 0xA2, 0x00, 0x69, 0x62, 0x6F, 0x6F, 0x6C, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x04, 0xF5, 0xA2, 0x00, 0x68, 0x69, 0x6E, 0x74, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x02, 0x0A, 0xA2, 0x00, 0x6A, 0x66, 0x6C, 0x6F, 0x61, 0x74, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0x4D, 0x00, 0xA2, 0x00, 0x68, 0x73, 0x74, 0x72, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x03, 0x6D, 0x68, 0x65, 0x6C, 0x6C, 0x6F, 0x20, 0x61, 0x72, 0x64, 0x75, 0x69, 0x6E, 0x6F};
+
+    THEN("Records split across chunks are decoded once complete")
+    {
+      for (size_t chunk_size = 1; chunk_size <= 7; chunk_size++) {
+        bool_test = false;
+        int_test = 1;
+        float_test = 2.0f;
+        str_test = "str_test";
+
+        REQUIRE(decodeInChunks(property_container, payload, sizeof(payload), 32, chunk_size));
+        REQUIRE(bool_test  == true);
+        REQUIRE(int_test   == 10);
+        REQUIRE(float_test == Approx(20.0).epsilon(0.01));
+        REQUIRE(str_test   == "hello arduino");
+      }
+    }
+
+    THEN("A record larger than the buffer fails the decoding")
+    {
+      REQUIRE_FALSE(decodeInChunks(property_container, payload, sizeof(payload), 16, 4));
+      /* The name of the next record does not fit next to the first one, which is not known to be complete */
+      REQUIRE(bool_test  == false);
+      REQUIRE(str_test   == "str_test");
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The records of a property received in chunks do not fit together into the buffer")
+  {
+    PropertyContainer property_container;
+
+    CloudTelevision tv_test = CloudTelevision(false, 0, false, PlaybackCommands::Stop, InputValue::AUX1, 0);
+
+    addPropertyToContainer(property_container, tv_test, "test", Permission::ReadWrite);
+
+    /* [{0: "test:swi", 4: true},{0: "test:vol", 2: 50},{0: "test:mut", 2: false},{0: "test:pbc", 2: 3},{0: "test:inp", 2: 55},{0: "test:cha", 2: 7}] */
+    uint8_t const payload[] = {0x9F, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x73, 0x77, 0x69, 0x04, 0xF5, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x76, 0x6F, 0x6C, 0x02, 0x18, 0x32, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x6D, 0x75, 0x74, 0x04, 0xF4, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x70, 0x62, 0x63, 0x02, 0x03, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x69, 0x6E, 0x70, 0x02, 0x18, 0x37, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x63, 0x68, 0x61, 0x02, 0x07, 0xFF};
+
+    THEN("The message is rejected without applying a part of the property")
+    {
+      REQUIRE_FALSE(decodeInChunks(property_container, payload, sizeof(payload), 32, 5));
+
+      Television tv_compare = Television(false, 0, false, PlaybackCommands::Stop, InputValue::AUX1, 0);
+      Television value_tv_test = tv_test.getValue();
+      bool verify = (value_tv_test == tv_compare);
+      REQUIRE(verify);
+    }
+
+    THEN("The property is applied once a buffer holds all its records")
+    {
+      REQUIRE(decodeInChunks(property_container, payload, sizeof(payload), 96, 5));
+
+      Television tv_compare = Television(true, 50, false, PlaybackCommands::Play, InputValue::TV, 7);
+      Television value_tv_test = tv_test.getValue();
+      bool verify = (value_tv_test == tv_compare);
+      REQUIRE(verify);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A record without a name follows the records of another property received in chunks")
+  {
+    PropertyContainer property_container;
+
+    CloudBool bool_test = false;
+    CloudInt  int_test = 1;
+
+    addPropertyToContainer(property_container, bool_test, "bool_test", Permission::ReadWrite);
+    addPropertyToContainer(property_container, int_test,  "int_test",  Permission::ReadWrite);
+
+    /* [{0: "bool_test", 4: true}, {0: "int_test", 2: 10}, {2: 20}] */
+    uint8_t const payload[] = {0x83, 0xA2, 0x00, 0x69, 0x62, 0x6F, 0x6F, 0x6C, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x04, 0xF5, 0xA2, 0x00, 0x68, 0x69, 0x6E, 0x74, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x02, 0x0A, 0xA1, 0x02, 0x14};
+
+    THEN("The record keeps the name of the previous record once the buffer is compacted")
+    {
+      for (size_t chunk_size = 1; chunk_size <= 4; chunk_size++) {
+        bool_test = false;
+        int_test = 1;
+
+        REQUIRE(decodeInChunks(property_container, payload, sizeof(payload), 28, chunk_size));
+        REQUIRE(bool_test == true);
+        REQUIRE(int_test  == 20);
+      }
+    }
+  }
+
+  /************************************************************************************/
+  WHEN("A property is changed by more records than are applied at once")
+  {
+    PropertyContainer property_container;
+
+    CloudTelevision tv_test = CloudTelevision(false, 0, false, PlaybackCommands::Stop, InputValue::AUX1, 0);
+
+    update_callback_count = 0;
+    addPropertyToContainer(property_container, tv_test, "test", Permission::ReadWrite).onUpdate(countUpdateCallback);
+
+    /* [{0: "test:swi", 4: true},{0: "test:vol", 2: 50},{0: "test:mut", 2: false},{0: "test:pbc", 2: 3},{0: "test:inp", 2: 55},{0: "test:cha", 2: 7},{0: "test:vol", 2: 60},{0: "test:cha", 2: 9},{0: "test:swi", 4: false}] = 9F A2 00 68 74 65 73 74 3A 73 77 69 04 F5 A2 00 68 74 65 73 74 3A 76 6F 6C 02 18 32 A2 00 68 74 65 73 74 3A 6D 75 74 04 F4 A2 00 68 74 65 73 74 3A 70 62 63 02 03 A2 00 68 74 65 73 74 3A 69 6E 70 02 18 37 A2 00 68 74 65 73 74 3A 63 68 61 02 07 A2 00 68 74 65 73 74 3A 76 6F 6C 02 18 3C A2 00 68 74 65 73 74 3A 63 68 61 02 09 A2 00 68 74 65 73 74 3A 73 77 69 04 F4 FF */
+    uint8_t const payload[] = {0x9F, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x73, 0x77, 0x69, 0x04, 0xF5, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x76, 0x6F, 0x6C, 0x02, 0x18, 0x32, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x6D, 0x75, 0x74, 0x04, 0xF4, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x70, 0x62, 0x63, 0x02, 0x03, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x69, 0x6E, 0x70, 0x02, 0x18, 0x37, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x63, 0x68, 0x61, 0x02, 0x07, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x76, 0x6F, 0x6C, 0x02, 0x18, 0x3C, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x63, 0x68, 0x61, 0x02, 0x09, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x73, 0x77, 0x69, 0x04, 0xF4, 0xFF};
+
+    THEN("None of the records is dropped and the property is applied once")
+    {
+      /* The 9 records exceed CborMapDataList::CAPACITY */
+      CBORDecoder::decode(property_container, payload, sizeof(payload) / sizeof(uint8_t));
+
+      Television tv_compare = Television(false, 60, false, PlaybackCommands::Play, InputValue::TV, 9);
+      Television value_tv_test = tv_test.getValue();
+      bool verify = (value_tv_test == tv_compare);
+      REQUIRE(verify);
+      REQUIRE(update_callback_count == 1);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A property is changed by records of more attributes than are held")
+  {
+    PropertyContainer property_container;
+
+    CloudTelevision tv_test = CloudTelevision(false, 0, false, PlaybackCommands::Stop, InputValue::AUX1, 0);
+
+    update_callback_count = 0;
+    addPropertyToContainer(property_container, tv_test, "test", Permission::ReadWrite).onUpdate(countUpdateCallback);
+
+    /* [{0: "test:a", 2: 1},{0: "test:b", 2: 1},{0: "test:c", 2: 1},{0: "test:d", 2: 1},{0: "test:e", 2: 1},{0: "test:f", 2: 1},{0: "test:g", 2: 1},{0: "test:h", 2: 1},{0: "test:i", 2: 1}] */
+    uint8_t const payload[] = {0x89, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x61, 0x02, 0x01, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x62, 0x02, 0x01, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x63, 0x02, 0x01, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x64, 0x02, 0x01, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x65, 0x02, 0x01, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x66, 0x02, 0x01, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x67, 0x02, 0x01, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x68, 0x02, 0x01, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x69, 0x02, 0x01};
+
+    THEN("The message is rejected and the property is not applied")
+    {
+      REQUIRE_FALSE(decodeInChunks(property_container, payload, sizeof(payload), 128, 8));
+      REQUIRE(update_callback_count == 0);
+    }
+  }
+
+  /************************************************************************************/
 }
@@ -0,0 +1,212 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <util/CBORTestUtil.h>
+
+#include <CBORDecoder.h>
+#include <PropertyContainer.h>
+#include "types/CloudWrapperInt.h"
+#include "types/CloudWrapperUnsignedInt.h"
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Only dirty Arduino Cloud Properties are checked by the encoder", "[ArduinoCloudThing::dirty]")
+{
+  set_millis(0);
+
+  WHEN("A property has been sent and is not changed afterwards")
+  {
+    PropertyContainer property_container;
+    CloudInt test = 1;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(0, 0);
+
+    REQUIRE(property_container.hasDirtyProperties());
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    THEN("The container has no dirty property and nothing is encoded") {
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+      REQUIRE(cbor::encode(property_container).size() == 0);
+    }
+    THEN("Changing the value marks it dirty again") {
+      test = 2;
+      REQUIRE(property_container.hasDirtyProperties());
+      REQUIRE(cbor::encode(property_container).size() != 0);
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+  }
+
+  WHEN("An update of an 'on demand' property is requested")
+  {
+    PropertyContainer property_container;
+    CloudInt test = 1;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnDemand();
+    cbor::encode(property_container);
+    REQUIRE_FALSE(property_container.hasDirtyProperties());
+
+    requestUpdateForAllProperties(property_container);
+
+    THEN("The property is dirty and encoded") {
+      REQUIRE(property_container.hasDirtyProperties());
+      REQUIRE(cbor::encode(property_container).size() != 0);
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+  }
+
+  WHEN("A property is changed by the cloud")
+  {
+    PropertyContainer property_container;
+    CloudInt test = 0;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+    cbor::encode(property_container);
+
+    /* [{0: "test", 2: 7}] = 81 A2 00 64 74 65 73 74 02 07 */
+    uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x07};
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+
+    THEN("The echo makes the property dirty") {
+      REQUIRE(test == 7);
+      REQUIRE(property_container.hasDirtyProperties());
+      REQUIRE(cbor::encode(property_container).size() != 0);
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+  }
+
+  WHEN("A container only holds the built-in timezone wrappers of a Thing")
+  {
+    PropertyContainer property_container;
+    int utc_offset = 0;
+    unsigned int utc_offset_expire_time = 0;
+    CloudWrapperInt utc_offset_wrapper(utc_offset);
+    CloudWrapperUnsignedInt utc_offset_expire_time_wrapper(utc_offset_expire_time);
+    addPropertyToContainer(property_container, utc_offset_wrapper, "tz_offset", Permission::ReadWrite, -1).writeOnDemand();
+    addPropertyToContainer(property_container, utc_offset_expire_time_wrapper, "tz_dst_until", Permission::ReadWrite, -1).writeOnDemand();
+
+    updateTimestampOnLocallyChangedProperties(property_container);
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    THEN("It is clean after the send") {
+      updateTimestampOnLocallyChangedProperties(property_container);
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+      REQUIRE(cbor::encode(property_container).size() == 0);
+    }
+    THEN("Polling marks a changed wrapped variable dirty until it is sent") {
+      set_millis(1000);
+      utc_offset = 3600;
+      utc_offset_expire_time = 1700000000;
+      updateTimestampOnLocallyChangedProperties(property_container);
+      REQUIRE(property_container.hasDirtyProperties());
+      REQUIRE(cbor::encode(property_container).size() != 0);
+      updateTimestampOnLocallyChangedProperties(property_container);
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+  }
+
+  WHEN("A changed wrapped variable waits for its minimum time between updates")
+  {
+    PropertyContainer property_container;
+    int value = 0;
+    CloudWrapperInt test(value);
+    set_millis(0);
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(0, 500);
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    set_millis(100);
+    value = 5;
+    updateTimestampOnLocallyChangedProperties(property_container);
+    REQUIRE(cbor::encode(property_container).size() == 0);
+
+    THEN("Polling does not mark it dirty again before its deadline") {
+      set_millis(200);
+      updateTimestampOnLocallyChangedProperties(property_container);
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+    THEN("It is sent once its deadline expires") {
+      set_millis(500);
+      updateTimestampOnLocallyChangedProperties(property_container);
+      REQUIRE(property_container.hasDirtyProperties());
+      REQUIRE(cbor::encode(property_container).size() != 0);
+    }
+  }
+
+  WHEN("A property is stored while disconnected")
+  {
+    PropertyContainer property_container;
+    CloudInt test = 1;
+    Property & property = addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(0, 0);
+
+    REQUIRE(property.shouldBeUpdated());
+    property.markStored();
+
+    THEN("It is not stored again until it changes") {
+      REQUIRE(property.isStored());
+      REQUIRE_FALSE(property.shouldBeUpdated());
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+      test = 2;
+      REQUIRE(property.shouldBeUpdated());
+    }
+    THEN("Its append completes once the stored value has been sent") {
+      property.appendCompleted();
+      REQUIRE_FALSE(property.isStored());
+      REQUIRE(cbor::encode(property_container).size() == 0);
+    }
+    THEN("It is sent again if the stored value is lost") {
+      property.storeDropped();
+      REQUIRE_FALSE(property.isStored());
+      REQUIRE(property_container.hasDirtyProperties());
+      REQUIRE(cbor::encode(property_container).size() != 0);
+    }
+  }
+
+  WHEN("A write-only property is added")
+  {
+    PropertyContainer property_container;
+    CloudInt test = 0;
+    addPropertyToContainer(property_container, test, "test", Permission::Write);
+
+    THEN("It is never dirty") {
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+      test = 3;
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+  }
+
+  WHEN("A dirty property is registered in another container")
+  {
+    PropertyContainer property_container, other_property_container;
+    CloudInt test = 0;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+    REQUIRE(property_container.hasDirtyProperties());
+    addPropertyToContainer(other_property_container, test, "test", Permission::ReadWrite);
+
+    THEN("Its dirty state moves to the new container") {
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+      REQUIRE(other_property_container.hasDirtyProperties());
+      REQUIRE(cbor::encode(other_property_container).size() != 0);
+      REQUIRE_FALSE(other_property_container.hasDirtyProperties());
+    }
+  }
+
+  WHEN("A copy of a registered property is modified")
+  {
+    PropertyContainer property_container;
+    CloudInt test = 0;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+    cbor::encode(property_container);
+
+    CloudInt copy = test + 1;
+
+    THEN("The container is not affected") {
+      REQUIRE(copy == 1);
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+  }
+}
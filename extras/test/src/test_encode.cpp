@@ -11,6 +11,7 @@
 #include <memory>
 
 #include <util/CBORTestUtil.h>
+#include <CBOREncoder.h>
 #include "types/CloudWrapperBool.h"
 #include "types/CloudWrapperFloat.h"
 #include "types/CloudWrapperInt.h"
@@ -89,6 +90,62 @@ SCENARIO("Arduino Cloud Properties are encoded", "[ArduinoCloudThing::encode-1]"
 
   /************************************************************************************/
 
+  WHEN("A 'float' property is added - compact floats")
+  {
+    PropertyContainer property_container;
+    cbor::encode(property_container);
+
+    CloudFloat float_test;
+    addPropertyToContainer(property_container, float_test, "test", Permission::ReadWrite);
+
+    THEN("An integral value is encoded as an integer")
+    {
+      float_test = 21.0f;
+      /* [{0: "test", 2: 21}] = 9F A2 00 64 74 65 73 74 02 15 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x15, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container, false, false, true);
+      REQUIRE(actual == expected);
+    }
+
+    THEN("A value exactly representable in half precision is encoded as a half float")
+    {
+      float_test = -21.5f;
+      /* [{0: "test", 2: -21.5}] = 9F A2 00 64 74 65 73 74 02 F9 CD 60 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0xCD, 0x60, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container, false, false, true);
+      REQUIRE(actual == expected);
+    }
+
+    THEN("A value not representable in half precision is encoded as a float")
+    {
+      float_test = 3.14159f;
+      /* [{0: "test", 2: 3.141590118408203}] = 9F A2 00 64 74 65 73 74 02 FA 40 49 0F D0 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xFA, 0x40, 0x49, 0x0F, 0xD0, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container, false, false, true);
+      REQUIRE(actual == expected);
+    }
+
+    THEN("A value within the minimum delta of the property from a half float is encoded as a half float")
+    {
+      property_container[0]->publishOnChange(0.01f);
+      float_test = 3.14159f;
+      /* [{0: "test", 2: 3.140625}] = 9F A2 00 64 74 65 73 74 02 F9 42 48 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0x42, 0x48, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container, false, false, true);
+      REQUIRE(actual == expected);
+    }
+
+    THEN("Values out of the half precision range are encoded as floats")
+    {
+      float_test = 1.0e-9f;
+      std::vector<uint8_t> const actual = cbor::encode(property_container, false, false, true);
+      REQUIRE(actual.size() == 15);
+      REQUIRE(actual[9] == 0xFA);
+    }
+  }
+
+  /************************************************************************************/
+
   WHEN("A 'String' property is added")
   {
     PropertyContainer property_container;
@@ -122,6 +179,69 @@ SCENARIO("Arduino Cloud Properties are encoded", "[ArduinoCloudThing::encode-1]"
 
   /************************************************************************************/
 
+  WHEN("A 'Location' property is added - SenML base compression")
+  {
+    PropertyContainer property_container;
+    cbor::encode(property_container);
+
+    CloudLocation location_test = CloudLocation(2.0f, 3.0f);
+    addPropertyToContainer(property_container, location_test, "test", Permission::ReadWrite);
+
+    /* [{-2: "test:", 0: "lat", 2: 2},{0: "lon", 2: 3}] = 9F A3 21 65 74 65 73 74 3A 00 63 6C 61 74 02 FA 40 00 00 00 A2 00 63 6C 6F 6E 02 FA 40 40 00 00 FF */
+    std::vector<uint8_t> const expected = { 0x9F, 0xA3, 0x21, 0x65, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x00, 0x63, 0x6C, 0x61, 0x74, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x63, 0x6C, 0x6F, 0x6E, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xFF };
+    std::vector<uint8_t> const actual = cbor::encode(property_container, false, true);
+    REQUIRE(actual == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("Properties with and without timestamp are added - SenML base compression")
+  {
+    PropertyContainer property_container;
+    cbor::encode(property_container);
+
+    CloudInt a = 1;
+    CloudInt b = 2;
+    addPropertyToContainer(property_container, a, "a", Permission::ReadWrite).encodeTimestamp();
+    addPropertyToContainer(property_container, b, "b", Permission::ReadWrite);
+    a.setTimestamp(1000);
+
+    /* The base time of 'a' must not be inherited by 'b'
+     * [{-2: "a", -3: 1000, 2: 1},{-2: "b", -3: 0, 2: 2}] = 9F A3 21 61 61 22 19 03 E8 02 01 A3 21 61 62 22 00 02 02 FF
+     */
+    std::vector<uint8_t> const expected = { 0x9F, 0xA3, 0x21, 0x61, 0x61, 0x22, 0x19, 0x03, 0xE8, 0x02, 0x01, 0xA3, 0x21, 0x61, 0x62, 0x22, 0x00, 0x02, 0x02, 0xFF };
+    std::vector<uint8_t> const actual = cbor::encode(property_container, false, true);
+    REQUIRE(actual == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A property is encoded with the time of its last local change - SenML base compression")
+  {
+    PropertyContainer property_container;
+
+    CloudInt a = 1;
+    addPropertyToContainer(property_container, a, "a", Permission::ReadWrite);
+    a.setLastLocalChangeTimestamp(1000);
+
+    uint8_t buf[32];
+    CborEncoder encoder, array_encoder;
+    SenMLBase senml_base;
+    cbor_encoder_init(&encoder, buf, sizeof(buf), 0);
+    REQUIRE(cbor_encoder_create_array(&encoder, &array_encoder, CborIndefiniteLength) == CborNoError);
+    REQUIRE(a.encode(&array_encoder, false, &senml_base, false, true) == CborNoError);
+    REQUIRE(cbor_encoder_close_container(&encoder, &array_encoder) == CborNoError);
+
+    /* The time of the change is the base time of the record
+     * [{-2: "a", -3: 1000, 2: 1}] = 9F A3 21 61 61 22 19 03 E8 02 01 FF
+     */
+    std::vector<uint8_t> const expected = { 0x9F, 0xA3, 0x21, 0x61, 0x61, 0x22, 0x19, 0x03, 0xE8, 0x02, 0x01, 0xFF };
+    std::vector<uint8_t> const actual(buf, buf + cbor_encoder_get_buffer_size(&encoder, buf));
+    REQUIRE(actual == expected);
+  }
+
+  /************************************************************************************/
+
   WHEN("A 'Color' property is added")
   {
     PropertyContainer property_container;
@@ -156,6 +276,22 @@ SCENARIO("Arduino Cloud Properties are encoded", "[ArduinoCloudThing::encode-1]"
 
   /************************************************************************************/
 
+  WHEN("A 'Color' property with an identifier exceeding 8 bit is added - light payload")
+  {
+    PropertyContainer property_container;
+    cbor::encode(property_container);
+
+    CloudColor color_test = CloudColor(2.0, 2.0, 2.0);
+    addPropertyToContainer(property_container, color_test, "test", Permission::ReadWrite, 300);
+
+    /* [{0: 131372, 2: 2.0},{0: 196908, 2: 2.0},{0: 262444, 2: 2.0}] = 9F A2 00 1A 00 02 01 2C 02 FA 40 00 00 00 A2 00 1A 00 03 01 2C 02 FA 40 00 00 00 A2 00 1A 00 04 01 2C 02 FA 40 00 00 00 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x1A, 0x00, 0x02, 0x01, 0x2C, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x1A, 0x00, 0x03, 0x01, 0x2C, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x1A, 0x00, 0x04, 0x01, 0x2C, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xFF };
+    std::vector<uint8_t> const actual = cbor::encode(property_container, true);
+    REQUIRE(actual == expected);
+  }
+
+  /************************************************************************************/
+
   WHEN("A 'ColoredLight' property is added")
   {
     PropertyContainer property_container;
@@ -494,6 +630,166 @@ SCENARIO("Arduino Cloud Properties are encoded", "[ArduinoCloudThing::encode-1]"
   }
 
 
+  /************************************************************************************/
+
+  WHEN("The encoded properties fill the CBOR buffer up to the last byte")
+  {
+    PropertyContainer property_container;
+
+    CloudInt int_0; int_0 = 1000000;
+    CloudInt int_1; int_1 = 1000001;
+
+    addPropertyToContainer(property_container, int_0, "int_value_0", Permission::ReadWrite);
+    addPropertyToContainer(property_container, int_1, "int_value_1", Permission::ReadWrite);
+
+    /* [{0: "int_value_0", 2: 1000000}, {0: "int_value_1", 2: 1000001}] = 42 bytes */
+    uint8_t buf[42] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+
+    THEN("All properties are packed when the message matches the buffer size")
+    {
+      REQUIRE(CBOREncoder::encode(property_container, buf, 42, bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(bytes_encoded == 42);
+      REQUIRE(buf[41] == 0xFF);
+      REQUIRE(current_property_index == 0);
+    }
+
+    THEN("A property not leaving room for closing the message is left for the next message")
+    {
+      REQUIRE(CBOREncoder::encode(property_container, buf, 41, bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(bytes_encoded == 22);
+      REQUIRE(buf[21] == 0xFF);
+      REQUIRE(current_property_index == 1);
+      REQUIRE(property_container.hasDirtyProperties());
+
+      REQUIRE(CBOREncoder::encode(property_container, buf, 41, bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(bytes_encoded == 22);
+      REQUIRE(current_property_index == 0);
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("High priority properties are changed together with other properties")
+  {
+    PropertyContainer property_container;
+
+    CloudInt int_0; int_0 = 1000000;
+    CloudInt int_1; int_1 = 1000001;
+    CloudInt int_2; int_2 = 1000002;
+    CloudInt int_3; int_3 = 1000003;
+
+    addPropertyToContainer(property_container, int_0, "int_value_0", Permission::ReadWrite);
+    addPropertyToContainer(property_container, int_1, "int_value_1", Permission::ReadWrite);
+    addPropertyToContainer(property_container, int_2, "int_value_2", Permission::ReadWrite).priority(Priority::High);
+    addPropertyToContainer(property_container, int_3, "int_value_3", Permission::ReadWrite).priority(Priority::High);
+
+    /* A single property {0: "int_value_x", 2: 100000x} fits into a 41 bytes buffer, the last
+     * character of the name is the 15th byte of the message.
+     */
+    uint8_t buf[41] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+
+    THEN("They are sent first, in turn, before the other ones")
+    {
+      char const expected_order[] = {'2', '3', '0', '1'};
+      for (char const expected : expected_order)
+      {
+        REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+        REQUIRE(bytes_encoded == 22);
+        REQUIRE(buf[14] == expected);
+      }
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+
+    THEN("A high priority property changed again overtakes the pending ones")
+    {
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(buf[14] == '0');
+
+      set_millis(millis() + Property::DEFAULT_MIN_TIME_BETWEEN_UPDATES_MILLIS);
+      int_2 = 2000002;
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(buf[14] == '2');
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(buf[14] == '1');
+    }
+
+    THEN("A property moved back to the normal class is sent in its turn")
+    {
+      int_3.priority(Priority::Normal);
+      REQUIRE(property_container.highPriorityProperties().size() == 1);
+
+      char const expected_order[] = {'2', '0', '1', '3'};
+      for (char const expected : expected_order)
+      {
+        REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+        REQUIRE(buf[14] == expected);
+      }
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A high priority property does not fit into an empty message")
+  {
+    PropertyContainer property_container;
+
+    CloudString str_0; str_0 = "A value which does not fit into a message of 41 bytes";
+    CloudInt int_0; int_0 = 1000000;
+
+    addPropertyToContainer(property_container, str_0, "str_0", Permission::ReadWrite).priority(Priority::High);
+    addPropertyToContainer(property_container, int_0, "int_value_0", Permission::ReadWrite);
+
+    uint8_t buf[41] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+
+    THEN("Its value is dropped and the other properties are sent")
+    {
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(bytes_encoded == 22);
+      REQUIRE(buf[14] == '0');
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The encoded properties span several messages")
+  {
+    PropertyContainer property_container;
+
+    CloudInt int_value[40];
+    for (size_t i = 0; i < 40; i++) {
+      int_value[i] = 1000000 + i;
+      addPropertyToContainer(property_container, int_value[i], String("int_value_") + std::to_string(i), Permission::ReadWrite);
+    }
+
+    /* Every call resumes from the property following the last one sent */
+    uint8_t buf[256] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+    unsigned int previous_property_index = 0;
+    size_t messages = 0;
+
+    do {
+      previous_property_index = current_property_index;
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(bytes_encoded > 0);
+      messages++;
+    } while (current_property_index > previous_property_index);
+
+    REQUIRE(current_property_index == 0);
+    REQUIRE(messages > 1);
+    REQUIRE_FALSE(property_container.hasDirtyProperties());
+  }
+
   /************************************************************************************/
 
   WHEN("The size of a single encoded properties is exceeding the CBOR buffer size")
@@ -0,0 +1,69 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdlib>
+#include <new>
+
+#include <PropertyContainer.h>
+#include <CBOREncoder.h>
+
+#include <types/automation/CloudTelevision.h>
+#include <types/CloudLocation.h>
+
+/**************************************************************************************
+   GLOBAL OPERATOR NEW/DELETE
+ **************************************************************************************/
+
+static size_t heap_allocation_count = 0;
+
+void * operator new(size_t size)
+{
+  heap_allocation_count++;
+  void * p = malloc(size ? size : 1);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void * p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void * p, size_t) noexcept
+{
+  free(p);
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Encoding multi-value properties does not allocate memory", "[ArduinoCloudThing::encode]")
+{
+  PropertyContainer property_container;
+
+  CloudTelevision tv;
+  CloudLocation location;
+  addPropertyToContainer(property_container, tv, "living_room_television_set", Permission::ReadWrite);
+  addPropertyToContainer(property_container, location, "a_property_name_longer_than_sso", Permission::ReadWrite);
+
+  uint8_t buf[256] = {0};
+  int bytes_encoded = 0;
+  unsigned int current_property_index = 0;
+
+  size_t const allocations_before = heap_allocation_count;
+  CborError const error = CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index, false);
+  size_t const allocations_after = heap_allocation_count;
+
+  REQUIRE(error == CborNoError);
+  REQUIRE(bytes_encoded > 0);
+  REQUIRE(allocations_after == allocations_before);
+}
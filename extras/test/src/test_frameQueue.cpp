@@ -0,0 +1,409 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+
+#include <utility/queue/FrameQueue.h>
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static bool push(FrameQueue & queue, int32_t const key, std::vector<uint8_t> const & data, bool const supersede = false)
+{
+  return queue.push(key, data.data(), data.size(), supersede);
+}
+
+static std::vector<uint8_t> peek(FrameQueue & queue, size_t const size, size_t & entries)
+{
+  std::vector<uint8_t> data(size);
+  data.resize(queue.peek(data.data(), data.size(), entries));
+  return data;
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Entries are sent in the order they have been stored", "[FrameQueue]")
+{
+  uint8_t buf[64];
+  RAMFrameQueueStorage storage(buf, sizeof(buf));
+  FrameQueue queue;
+  queue.begin(&storage);
+
+  REQUIRE(queue.empty());
+  REQUIRE(push(queue, 1, {0x01, 0x02}));
+  REQUIRE(push(queue, 2, {0x03}));
+  REQUIRE(push(queue, 1, {0x04, 0x05, 0x06}));
+  REQUIRE(queue.pending() == 3);
+
+  WHEN("All entries fit")
+  {
+    size_t entries = 0;
+    REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+    REQUIRE(entries == 3);
+
+    THEN("They are removed once sent")
+    {
+      queue.pop(entries);
+      REQUIRE(queue.empty());
+      REQUIRE(peek(queue, 16, entries).empty());
+      REQUIRE(entries == 0);
+    }
+  }
+
+  WHEN("Only some entries fit")
+  {
+    size_t entries = 0;
+    REQUIRE(peek(queue, 4, entries) == std::vector<uint8_t>{0x01, 0x02, 0x03});
+    REQUIRE(entries == 2);
+    queue.pop(entries);
+
+    THEN("The remaining ones are sent next")
+    {
+      REQUIRE(peek(queue, 4, entries) == std::vector<uint8_t>{0x04, 0x05, 0x06});
+      REQUIRE(entries == 1);
+    }
+  }
+}
+
+SCENARIO("A value supersedes the values of the same key not sent yet", "[FrameQueue]")
+{
+  uint8_t buf[64];
+  RAMFrameQueueStorage storage(buf, sizeof(buf));
+  FrameQueue queue;
+  queue.begin(&storage);
+
+  REQUIRE(push(queue, 1, {0x01}));
+  REQUIRE(push(queue, 2, {0x02}));
+  REQUIRE(push(queue, 1, {0x03}, true));
+  REQUIRE(queue.pending() == 2);
+
+  size_t entries = 0;
+  REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x02, 0x03});
+
+  WHEN("Every value not sent yet is superseded")
+  {
+    REQUIRE(push(queue, 2, {0x04}, true));
+    REQUIRE(push(queue, 1, {0x05}, true));
+
+    THEN("Only the last values are sent")
+    {
+      REQUIRE(queue.pending() == 2);
+      REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x04, 0x05});
+    }
+  }
+}
+
+SCENARIO("The queue is bounded by its storage", "[FrameQueue]")
+{
+  uint8_t buf[2 * (FrameQueue::ENTRY_HEADER_SIZE + 4)];
+  RAMFrameQueueStorage storage(buf, sizeof(buf));
+  FrameQueue queue;
+
+  WHEN("No storage is attached")
+  {
+    queue.begin(nullptr);
+    REQUIRE_FALSE(queue.isEnabled());
+    REQUIRE_FALSE(push(queue, 1, {0x01}));
+  }
+
+  WHEN("The storage is full")
+  {
+    queue.begin(&storage);
+    REQUIRE(push(queue, 1, {0x01, 0x02, 0x03, 0x04}));
+    REQUIRE(push(queue, 2, {0x05, 0x06, 0x07, 0x08}));
+    REQUIRE_FALSE(push(queue, 3, {0x09}));
+
+    THEN("Space is reclaimed once all the entries have been sent")
+    {
+      size_t entries = 0;
+      peek(queue, 16, entries);
+      queue.pop(entries);
+      REQUIRE(push(queue, 3, {0x09}));
+    }
+  }
+}
+
+/* RAM storage counting how often it is erased */
+class CountingFrameQueueStorage : public RAMFrameQueueStorage
+{
+public:
+  CountingFrameQueueStorage(uint8_t * buf, size_t const size) : RAMFrameQueueStorage(buf, size), erase_count{0} { }
+
+  virtual void erase() override
+  {
+    erase_count++;
+    RAMFrameQueueStorage::erase();
+  }
+
+  size_t erase_count;
+};
+
+SCENARIO("The storage is erased only once its space is needed", "[FrameQueue]")
+{
+  uint8_t buf[2 * (FrameQueue::ENTRY_HEADER_SIZE + 4)];
+  CountingFrameQueueStorage storage(buf, sizeof(buf));
+  size_t const erase_count = storage.erase_count;
+  FrameQueue queue;
+  queue.begin(&storage);
+
+  size_t entries = 0;
+  REQUIRE(push(queue, 1, {0x01, 0x02, 0x03, 0x04}));
+  peek(queue, 16, entries);
+  queue.pop(entries);
+  REQUIRE(push(queue, 2, {0x05, 0x06, 0x07, 0x08}));
+  peek(queue, 16, entries);
+  queue.pop(entries);
+  REQUIRE(queue.empty());
+  REQUIRE(storage.erase_count == erase_count);
+
+  REQUIRE(push(queue, 3, {0x09}));
+  REQUIRE(storage.erase_count == (erase_count + 1));
+  REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x09});
+}
+
+SCENARIO("Space of the superseded entries is reclaimed", "[FrameQueue]")
+{
+  size_t const entry_size = FrameQueue::ENTRY_HEADER_SIZE + 1;
+  uint8_t buf[4 * entry_size];
+  RAMFrameQueueStorage storage(buf, sizeof(buf));
+  FrameQueue queue;
+  queue.begin(&storage);
+
+  REQUIRE(push(queue, 1, {0x01}));
+
+  WHEN("A value of another key is pushed more often than entries fit into the storage")
+  {
+    for (uint8_t i = 0; i <= (sizeof(buf) / entry_size); i++) {
+      REQUIRE(push(queue, 2, {static_cast<uint8_t>(0x10 + i)}, true));
+    }
+
+    THEN("The pending entries are kept in order and other keys can still be pushed")
+    {
+      size_t entries = 0;
+      REQUIRE(queue.pending() == 2);
+      REQUIRE(push(queue, 3, {0x20}));
+      REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x01, 0x14, 0x20});
+    }
+
+    THEN("The compacted entries are recovered after a reset")
+    {
+      FrameQueue recovered_queue;
+      recovered_queue.begin(&storage);
+      size_t entries = 0;
+      REQUIRE(recovered_queue.pending() == 2);
+      REQUIRE(peek(recovered_queue, 16, entries) == std::vector<uint8_t>{0x01, 0x14});
+    }
+  }
+}
+
+SCENARIO("Stored entries are recovered after a reset", "[FrameQueue]")
+{
+  uint8_t buf[64];
+  RAMFrameQueueStorage storage(buf, sizeof(buf));
+
+  {
+    FrameQueue queue;
+    queue.begin(&storage);
+    REQUIRE(push(queue, 1, {0x01}));
+    REQUIRE(push(queue, 2, {0x02}));
+    REQUIRE(push(queue, 3, {0x03}));
+    size_t entries = 0;
+    peek(queue, 1, entries);
+    queue.pop(entries);
+  }
+
+  WHEN("The last entry has been written completely")
+  {
+    FrameQueue queue;
+    queue.begin(&storage);
+
+    THEN("Only the entries not sent are recovered")
+    {
+      size_t entries = 0;
+      REQUIRE(queue.pending() == 2);
+      REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x02, 0x03});
+    }
+  }
+
+  WHEN("The write of the last entry has been interrupted")
+  {
+    /* The state of the third entry is written last */
+    buf[2 * (FrameQueue::ENTRY_HEADER_SIZE + 1)] = 0xFF;
+
+    FrameQueue queue;
+    queue.begin(&storage);
+
+    THEN("The entry is discarded")
+    {
+      size_t entries = 0;
+      REQUIRE(queue.pending() == 1);
+      REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x02});
+      REQUIRE(push(queue, 4, {0x04}));
+      REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x02, 0x04});
+    }
+  }
+}
+
+SCENARIO("Entries are stored in a file", "[FrameQueue]")
+{
+  char const * path = "test_frame_queue.bin";
+  char const * scratch_path = "test_frame_queue.tmp";
+  remove(path);
+  remove(scratch_path);
+
+  {
+    FileFrameQueueStorage storage(path, scratch_path, 256);
+    FrameQueue queue;
+    queue.begin(&storage);
+    REQUIRE(push(queue, 1, {0x01, 0x02}));
+    REQUIRE(push(queue, 2, {0x03}));
+  }
+
+  FileFrameQueueStorage storage(path, scratch_path, 256);
+  FrameQueue queue;
+  queue.begin(&storage);
+
+  size_t entries = 0;
+  REQUIRE(queue.pending() == 2);
+  REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x01, 0x02, 0x03});
+
+  queue.pop(entries);
+  REQUIRE(queue.empty());
+  REQUIRE(push(queue, 3, {0x04}));
+  REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x04});
+
+  /* Superseding a value more often than entries fit compacts the file */
+  for (uint8_t i = 0; i < 64; i++) {
+    REQUIRE(push(queue, 4, {i, i}, true));
+  }
+  REQUIRE(peek(queue, 16, entries) == std::vector<uint8_t>{0x04, 63, 63});
+
+  remove(path);
+  remove(scratch_path);
+}
+
+/* File storage losing power after a given number of writes to the scratch file */
+class InterruptedFileFrameQueueStorage : public FileFrameQueueStorage
+{
+public:
+  InterruptedFileFrameQueueStorage(char const * path, char const * scratch_path, size_t const size, size_t const scratch_writes)
+  : FileFrameQueueStorage(path, scratch_path, size)
+  , _scratch_writes{scratch_writes}
+  { }
+
+  virtual bool writeScratch(size_t const offset, uint8_t const * data, size_t const len) override
+  {
+    if (_scratch_writes == 0)
+      return false;
+    _scratch_writes--;
+    return FileFrameQueueStorage::writeScratch(offset, data, len);
+  }
+
+  virtual bool commitScratch(size_t const len) override
+  {
+    return (_scratch_writes > 0) && FileFrameQueueStorage::commitScratch(len);
+  }
+
+private:
+  size_t _scratch_writes;
+};
+
+SCENARIO("An interrupted compaction of a file loses no entry", "[FrameQueue]")
+{
+  char const * path = "test_frame_queue_interrupted.bin";
+  char const * scratch_path = "test_frame_queue_interrupted.tmp";
+  size_t const entry_size = FrameQueue::ENTRY_HEADER_SIZE + 40;
+  std::vector<uint8_t> const first(40, 0x01), second(40, 0x02), third(40, 0x03), fourth(40, 0x04);
+
+  /* Interrupted before each write of the two 48 byte entries, copied in 64 byte chunks, and before the rename.
+   * Sections cannot be entered once per iteration, hence the recovery is checked within the loop.
+   */
+  for (size_t scratch_writes = 0; scratch_writes <= 2; scratch_writes++)
+  {
+    remove(path);
+    remove(scratch_path);
+
+    {
+      InterruptedFileFrameQueueStorage storage(path, scratch_path, 4 * entry_size, scratch_writes);
+      FrameQueue queue;
+      queue.begin(&storage);
+      REQUIRE(push(queue, 1, first));
+      REQUIRE(push(queue, 2, second));
+      REQUIRE(push(queue, 3, third));
+      REQUIRE(push(queue, 4, fourth));
+      size_t entries = 0;
+      peek(queue, 80, entries);
+      REQUIRE(entries == 2);
+      queue.pop(entries);
+
+      /* The compaction needed by the next entry is interrupted */
+      REQUIRE_FALSE(push(queue, 5, {0x05}));
+    }
+
+    /* The pending entries are recovered once, as before the compaction */
+    FileFrameQueueStorage storage(path, scratch_path, 4 * entry_size);
+    FrameQueue queue;
+    queue.begin(&storage);
+
+    size_t entries = 0;
+    std::vector<uint8_t> expected(third);
+    expected.insert(expected.end(), fourth.begin(), fourth.end());
+    REQUIRE(queue.pending() == 2);
+    REQUIRE(peek(queue, 160, entries) == expected);
+
+    /* The compaction succeeds after the reset */
+    REQUIRE(push(queue, 5, {0x05}));
+    expected.push_back(0x05);
+    REQUIRE(peek(queue, 160, entries) == expected);
+  }
+
+  WHEN("The file system cannot rename over a file and the reset happens in between")
+  {
+    remove(path);
+    remove(scratch_path);
+
+    {
+      FileFrameQueueStorage storage(path, scratch_path, 4 * entry_size);
+      FrameQueue queue;
+      queue.begin(&storage);
+      REQUIRE(push(queue, 1, first));
+      REQUIRE(push(queue, 2, second));
+      REQUIRE(push(queue, 3, third));
+      REQUIRE(push(queue, 4, fourth));
+      size_t entries = 0;
+      peek(queue, 80, entries);
+      queue.pop(entries);
+      REQUIRE(push(queue, 5, {0x05}));
+    }
+
+    /* The compacted entries are left in the scratch file only */
+    REQUIRE(rename(path, scratch_path) == 0);
+
+    THEN("The compacted entries are recovered")
+    {
+      FileFrameQueueStorage storage(path, scratch_path, 4 * entry_size);
+      FrameQueue queue;
+      queue.begin(&storage);
+
+      size_t entries = 0;
+      std::vector<uint8_t> expected(third);
+      expected.insert(expected.end(), fourth.begin(), fourth.end());
+      expected.push_back(0x05);
+      REQUIRE(queue.pending() == 3);
+      REQUIRE(peek(queue, 160, entries) == expected);
+    }
+  }
+
+  remove(path);
+  remove(scratch_path);
+}
@@ -0,0 +1,90 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <PropertyContainer.h>
+
+#include <types/CloudInt.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties are looked up by name or identifier", "[ArduinoCloudThing::getProperty]")
+{
+  PropertyContainer property_container;
+
+  static size_t const NUM_PROPERTIES = 100;
+  CloudInt int_property[NUM_PROPERTIES];
+
+  for (size_t i = 0; i < NUM_PROPERTIES; i++)
+    addPropertyToContainer(property_container, int_property[i], "int_property_" + std::to_string(i), Permission::ReadWrite);
+
+  WHEN("A property is looked up by name")
+  {
+    THEN("Every registered property is found") {
+      for (size_t i = 0; i < NUM_PROPERTIES; i++)
+        REQUIRE(getProperty(property_container, "int_property_" + std::to_string(i)) == &int_property[i]);
+    }
+    THEN("An unknown name is not found") {
+      REQUIRE(getProperty(property_container, String("int_property_")) == nullptr);
+      REQUIRE(getProperty(property_container, String("unknown")) == nullptr);
+    }
+  }
+
+  WHEN("A property is looked up by identifier")
+  {
+    THEN("Every registered property is found using the incrementally assigned identifier") {
+      for (size_t i = 0; i < NUM_PROPERTIES; i++)
+        REQUIRE(getProperty(property_container, static_cast<int>(i + 1)) == &int_property[i]);
+    }
+    THEN("An unknown identifier is not found") {
+      REQUIRE(getProperty(property_container, 0) == nullptr);
+      REQUIRE(getProperty(property_container, static_cast<int>(NUM_PROPERTIES + 1)) == nullptr);
+    }
+  }
+
+  WHEN("Two properties are registered with the same identifier")
+  {
+    PropertyContainer tagged_property_container;
+    CloudInt first, second;
+    addPropertyToContainer(tagged_property_container, first,  "first",  Permission::ReadWrite, 7);
+    addPropertyToContainer(tagged_property_container, second, "second", Permission::ReadWrite, 7);
+
+    THEN("The property registered first is returned") {
+      REQUIRE(getProperty(tagged_property_container, 7) == &first);
+      REQUIRE(getProperty(tagged_property_container, String("second")) == &second);
+    }
+  }
+
+  WHEN("A property is registered with a string literal as name")
+  {
+    static char const NAME[] = "literal";
+    CloudInt literal;
+    addPropertyToContainer(property_container, literal, NAME, Permission::ReadWrite);
+
+    THEN("The name is referenced in place instead of being copied") {
+      REQUIRE(literal.name() == NAME);
+      REQUIRE(getProperty(property_container, "literal") == &literal);
+    }
+  }
+
+  WHEN("A property is registered with a name too long to be encoded with its attributes")
+  {
+    CloudInt longest, too_long;
+    addPropertyToContainer(property_container, longest,  String(Property::MAX_NAME_LENGTH, 'a'),     Permission::ReadWrite);
+    addPropertyToContainer(property_container, too_long, String(Property::MAX_NAME_LENGTH + 1, 'b'), Permission::ReadWrite);
+
+    THEN("Only the name fitting the attribute key is registered") {
+      REQUIRE(getProperty(property_container, String(Property::MAX_NAME_LENGTH, 'a')) == &longest);
+      REQUIRE(getProperty(property_container, String(Property::MAX_NAME_LENGTH + 1, 'b')) == nullptr);
+      REQUIRE(too_long.getContainer() == nullptr);
+    }
+  }
+}
@@ -0,0 +1,235 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string.h>
+
+#include <vector>
+
+#include <message/MessageQueue.h>
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static OtaProgressCmdUp otaProgress(uint8_t const state, int32_t const state_data)
+{
+  OtaProgressCmdUp msg;
+  msg.c.id = OtaProgressCmdUpId;
+  memset(msg.params.id, 0xAA, ID_SIZE);
+  msg.params.state = state;
+  msg.params.state_data = state_data;
+  msg.params.time = 0;
+  return msg;
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Messages are sent in the order they have been delivered", "[MessageQueue]")
+{
+  MessageQueue queue;
+  MessageStream & stream = queue;
+
+  REQUIRE(queue.empty());
+  REQUIRE(queue.front() == nullptr);
+
+  DeviceBeginCmd deviceBegin = { DeviceBeginCmdId, "1.0.0" };
+  ThingBeginCmd thingBegin = { ThingBeginCmdId, "thing" };
+  REQUIRE(stream.sendUpstream(reinterpret_cast<Message*>(&deviceBegin)));
+  REQUIRE(stream.sendUpstream(reinterpret_cast<Message*>(&thingBegin)));
+  REQUIRE(queue.size() == 2);
+
+  WHEN("The queue is drained")
+  {
+    THEN("The messages are copies of the delivered ones, in order")
+    {
+      REQUIRE(queue.front()->id == DeviceBeginCmdId);
+      REQUIRE(strcmp(reinterpret_cast<DeviceBeginCmd *>(queue.front())->params.lib_version, "1.0.0") == 0);
+      queue.pop();
+      REQUIRE(queue.front()->id == ThingBeginCmdId);
+      REQUIRE(strcmp(reinterpret_cast<ThingBeginCmd *>(queue.front())->params.thing_id, "thing") == 0);
+      queue.pop();
+      REQUIRE(queue.empty());
+    }
+  }
+
+  WHEN("The queue is cleared")
+  {
+    queue.clear();
+    REQUIRE(queue.empty());
+    REQUIRE(queue.front() == nullptr);
+  }
+}
+
+SCENARIO("A message supersedes the pending message it duplicates", "[MessageQueue]")
+{
+  MessageQueue queue;
+
+  WHEN("The same command is delivered again")
+  {
+    Message lastValuesBegin = { LastValuesBeginCmdId };
+    Message propertiesUpdate = { PropertiesUpdateCmdId };
+    REQUIRE(queue.sendUpstream(&lastValuesBegin));
+    REQUIRE(queue.sendUpstream(&propertiesUpdate));
+    REQUIRE(queue.sendUpstream(&lastValuesBegin));
+    REQUIRE(queue.sendUpstream(&propertiesUpdate));
+
+    THEN("It is sent once, after the messages delivered in between")
+    {
+      REQUIRE(queue.size() == 2);
+      REQUIRE(queue.front()->id == LastValuesBeginCmdId);
+      queue.pop();
+      REQUIRE(queue.front()->id == PropertiesUpdateCmdId);
+    }
+  }
+
+  WHEN("A command is delivered again after a different one")
+  {
+    Message lastValuesBegin = { LastValuesBeginCmdId };
+    Message propertiesUpdate = { PropertiesUpdateCmdId };
+    REQUIRE(queue.sendUpstream(&lastValuesBegin));
+    REQUIRE(queue.sendUpstream(&propertiesUpdate));
+    REQUIRE(queue.sendUpstream(&lastValuesBegin));
+
+    THEN("The pending one is dropped and the new one follows the other command")
+    {
+      REQUIRE(queue.size() == 2);
+      REQUIRE(queue.front()->id == PropertiesUpdateCmdId);
+      queue.pop();
+      REQUIRE(queue.front()->id == LastValuesBeginCmdId);
+    }
+  }
+
+  WHEN("The same command is delivered again with other parameters")
+  {
+    ThingBeginCmd thingBegin1 = { ThingBeginCmdId, "thing1" };
+    ThingBeginCmd thingBegin2 = { ThingBeginCmdId, "thing2" };
+    REQUIRE(queue.sendUpstream(reinterpret_cast<Message*>(&thingBegin1)));
+    REQUIRE(queue.sendUpstream(reinterpret_cast<Message*>(&thingBegin2)));
+    REQUIRE(queue.sendUpstream(reinterpret_cast<Message*>(&thingBegin2)));
+
+    THEN("Only the duplicate is dropped")
+    {
+      REQUIRE(queue.size() == 2);
+      REQUIRE(strcmp(reinterpret_cast<ThingBeginCmd *>(queue.front())->params.thing_id, "thing1") == 0);
+      queue.pop();
+      REQUIRE(strcmp(reinterpret_cast<ThingBeginCmd *>(queue.front())->params.thing_id, "thing2") == 0);
+    }
+  }
+
+  WHEN("OTA progress reports are delivered")
+  {
+    OtaProgressCmdUp fetch1 = otaProgress(3, 100);
+    OtaProgressCmdUp fetch2 = otaProgress(3, 200);
+    OtaProgressCmdUp flash  = otaProgress(4, 0);
+    REQUIRE(queue.sendUpstream(reinterpret_cast<Message*>(&fetch1)));
+    REQUIRE(queue.sendUpstream(reinterpret_cast<Message*>(&fetch2)));
+    REQUIRE(queue.sendUpstream(reinterpret_cast<Message*>(&flash)));
+
+    THEN("Only the reports of different states are kept, with the latest progress")
+    {
+      REQUIRE(queue.size() == 2);
+      REQUIRE(reinterpret_cast<OtaProgressCmdUp *>(queue.front())->params.state_data == 200);
+      queue.pop();
+      REQUIRE(reinterpret_cast<OtaProgressCmdUp *>(queue.front())->params.state == 4);
+    }
+  }
+}
+
+SCENARIO("The queue is bounded", "[MessageQueue]")
+{
+  MessageQueue queue;
+
+  for (uint8_t state = 0; state < MessageQueue::CAPACITY; state++) {
+    OtaProgressCmdUp progress = otaProgress(state, 0);
+    REQUIRE(queue.sendUpstream(reinterpret_cast<Message*>(&progress)));
+  }
+  REQUIRE(queue.full());
+
+  WHEN("A new message is delivered")
+  {
+    Message lastValuesBegin = { LastValuesBeginCmdId };
+
+    THEN("It is rejected until a message has been sent")
+    {
+      REQUIRE_FALSE(queue.sendUpstream(&lastValuesBegin));
+      queue.pop();
+      REQUIRE(queue.sendUpstream(&lastValuesBegin));
+    }
+  }
+
+  WHEN("A message duplicating a pending one is delivered")
+  {
+    OtaProgressCmdUp progress = otaProgress(0, 100);
+
+    THEN("It is accepted, at the tail of the queue")
+    {
+      REQUIRE(queue.sendUpstream(reinterpret_cast<Message*>(&progress)));
+      REQUIRE(queue.full());
+      for (size_t i = 1; i < MessageQueue::CAPACITY; i++) {
+        queue.pop();
+      }
+      REQUIRE(reinterpret_cast<OtaProgressCmdUp *>(queue.front())->params.state == 0);
+      REQUIRE(reinterpret_cast<OtaProgressCmdUp *>(queue.front())->params.state_data == 100);
+    }
+  }
+}
+
+SCENARIO("The pending messages are flushed through the sender", "[MessageQueue]")
+{
+  std::vector<CommandId> sent;
+  bool accept = true;
+  MessageQueue queue([&sent, &accept](Message * m) {
+    if (accept) {
+      sent.push_back(static_cast<CommandId>(m->id));
+    }
+    return accept;
+  });
+  MessageStream & stream = queue;
+
+  WHEN("A status report is queued right before a reboot")
+  {
+    OtaProgressCmdUp flash  = otaProgress(4, 0);
+    OtaProgressCmdUp reboot = otaProgress(5, 0);
+    REQUIRE(stream.sendUpstream(reinterpret_cast<Message*>(&flash)));
+    REQUIRE(stream.sendUpstream(reinterpret_cast<Message*>(&reboot)));
+    stream.flush();
+
+    THEN("It is sent before the flush returns")
+    {
+      REQUIRE(queue.empty());
+      REQUIRE(sent.size() == 2);
+      REQUIRE(sent[0] == OtaProgressCmdUpId);
+      REQUIRE(sent[1] == OtaProgressCmdUpId);
+    }
+  }
+
+  WHEN("A message cannot be sent")
+  {
+    Message lastValuesBegin = { LastValuesBeginCmdId };
+    Message propertiesUpdate = { PropertiesUpdateCmdId };
+    REQUIRE(stream.sendUpstream(&lastValuesBegin));
+    REQUIRE(stream.sendUpstream(&propertiesUpdate));
+    accept = false;
+    stream.flush();
+
+    THEN("It stays pending with the following ones, until it can be sent")
+    {
+      REQUIRE(queue.size() == 2);
+      accept = true;
+      stream.flush();
+      REQUIRE(queue.empty());
+      REQUIRE(sent.size() == 2);
+      REQUIRE(sent[0] == LastValuesBeginCmdId);
+      REQUIRE(sent[1] == PropertiesUpdateCmdId);
+    }
+  }
+}
@@ -0,0 +1,67 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <PropertyArena.h>
+
+#include <types/CloudWrapperInt.h>
+#include <types/CloudWrapperBool.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Property wrappers are placed in a statically sized arena", "[PropertyArena]")
+{
+  alignas(max_align_t) static uint8_t buffer[2 * sizeof(CloudWrapperInt)];
+  PropertyArena arena(buffer, sizeof(buffer));
+
+  WHEN("Objects are allocated until the arena is full")
+  {
+    void * first  = arena.allocate(sizeof(CloudWrapperInt), alignof(CloudWrapperInt));
+    void * second = arena.allocate(sizeof(CloudWrapperInt), alignof(CloudWrapperInt));
+
+    THEN("They are placed next to each other")
+    {
+      REQUIRE(first == buffer);
+      REQUIRE(second == buffer + sizeof(CloudWrapperInt));
+      REQUIRE(arena.used() == arena.capacity());
+      REQUIRE(arena.highWaterMark() == arena.capacity());
+    }
+
+    THEN("Further allocations fail but their size is accounted in the high-water mark")
+    {
+      REQUIRE(arena.allocate(sizeof(CloudWrapperBool), alignof(CloudWrapperBool)) == nullptr);
+      REQUIRE(arena.used() == arena.capacity());
+      REQUIRE(arena.highWaterMark() == arena.capacity() + sizeof(CloudWrapperBool));
+    }
+  }
+
+  WHEN("An object with stricter alignment follows a smaller one")
+  {
+    arena.allocate(1, 1);
+    void * p = arena.allocate(sizeof(CloudWrapperInt), alignof(CloudWrapperInt));
+
+    THEN("It is correctly aligned")
+    {
+      REQUIRE(p != nullptr);
+      REQUIRE(reinterpret_cast<uintptr_t>(p) % alignof(CloudWrapperInt) == 0);
+    }
+  }
+}
+
+SCENARIO("A property wrapper is created for a primitive variable", "[PropertyArena]")
+{
+  int value = 5;
+  Property * p = createPropertyWrapper<CloudWrapperInt>(value);
+
+  REQUIRE(p != nullptr);
+  REQUIRE(p->isPrimitive());
+  delete p;
+}
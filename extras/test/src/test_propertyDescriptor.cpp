@@ -0,0 +1,147 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <util/CBORTestUtil.h>
+
+#include <types/CloudWrapperInt.h>
+
+/**************************************************************************************
+   GLOBAL VARIABLES
+ **************************************************************************************/
+
+static CloudInt   descriptor_counter;
+static CloudFloat descriptor_temperature;
+static CloudBool  descriptor_led;
+
+static bool descriptor_led_update_callback_called = false;
+static void onDescriptorLedChange() { descriptor_led_update_callback_called = true; }
+
+static constexpr PropertyDescriptor thing_properties[] =
+{
+  describeProperty(descriptor_counter,     "counter",     Permission::Read,      1).publishEvery(10),
+  describeProperty(descriptor_temperature, "temperature", Permission::Read,      2).publishOnChange(0.5f, 1000),
+  describeProperty(descriptor_led,         "led",         Permission::ReadWrite, 3).onUpdate(onDescriptorLedChange),
+};
+
+static int             descriptor_level = 0;
+static CloudWrapperInt descriptor_level_wrapper(descriptor_level);
+
+static constexpr PropertyDescriptor wrapped_properties[] =
+{
+  describeProperty(descriptor_level_wrapper, "level", Permission::ReadWrite, 1),
+};
+
+static constexpr PropertyDescriptor duplicated_properties[] =
+{
+  describeProperty(descriptor_counter, "counter", Permission::Read, 1),
+  describeProperty(descriptor_led,     "counter", Permission::Read, 1),
+};
+
+static_assert(hasUniquePropertyNames(thing_properties), "");
+static_assert(hasUniquePropertyIdentifiers(thing_properties), "");
+static_assert(!hasUniquePropertyNames(duplicated_properties), "");
+static_assert(!hasUniquePropertyIdentifiers(duplicated_properties), "");
+static_assert(findPropertyDescriptor(thing_properties, "temperature") == 1, "");
+static_assert(findPropertyDescriptor(thing_properties, "humidity") == -1, "");
+static_assert(thing_properties[0].update_policy == UpdatePolicy::TimeInterval, "");
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties are registered from a compile time descriptor table", "[ArduinoCloudThing::addPropertiesToContainer]")
+{
+  PropertyContainer property_container;
+
+  addPropertiesToContainer(property_container, thing_properties, sizeof(thing_properties) / sizeof(thing_properties[0]));
+
+  REQUIRE(property_container.size() == 3);
+
+  WHEN("The properties are looked up")
+  {
+    THEN("Names, identifiers and permissions are taken from the table")
+    {
+      REQUIRE(getProperty(property_container, "counter") == &descriptor_counter);
+      REQUIRE(getProperty(property_container, 2) == &descriptor_temperature);
+      REQUIRE(descriptor_led.isWriteableByCloud());
+      REQUIRE_FALSE(descriptor_counter.isWriteableByCloud());
+    }
+    THEN("The names of the table are referenced in place")
+    {
+      REQUIRE(descriptor_counter.name() == thing_properties[0].name);
+    }
+  }
+
+  WHEN("A primitive variable is described through a wrapper")
+  {
+    PropertyContainer wrapped_container;
+    addPropertiesToContainer(wrapped_container, wrapped_properties, 1);
+
+    THEN("The wrapper is registered in place of the variable")
+    {
+      REQUIRE(getProperty(wrapped_container, "level") == &descriptor_level_wrapper);
+    }
+  }
+
+  WHEN("The led property is changed by the cloud")
+  {
+    descriptor_led_update_callback_called = false;
+    descriptor_led.execCallbackOnChange();
+    THEN("The update callback of the table is called")
+    {
+      REQUIRE(descriptor_led_update_callback_called);
+    }
+  }
+
+  WHEN("The properties are encoded")
+  {
+    set_millis(0);
+    THEN("Every property is sent once")
+    {
+      REQUIRE(cbor::encode(property_container).size() != 0);
+      descriptor_temperature = descriptor_temperature + 1.0f;
+      set_millis(500);
+      /* Rate limit of the temperature and interval of the counter not yet elapsed */
+      REQUIRE(cbor::encode(property_container).size() == 0);
+      set_millis(1000);
+      REQUIRE(cbor::encode(property_container).size() != 0);
+    }
+  }
+}
+
+SCENARIO("A large table of Arduino Cloud Properties is registered at once", "[ArduinoCloudThing::addPropertiesToContainer]")
+{
+  PropertyContainer property_container;
+
+  static size_t const PROPERTY_COUNT = 100;
+  CloudInt property[PROPERTY_COUNT];
+  String name[PROPERTY_COUNT];
+  PropertyDescriptor descriptors[PROPERTY_COUNT + 1];
+
+  for (size_t i = 0; i < PROPERTY_COUNT; i++) {
+    name[i] = String("property_") + std::to_string(i);
+    descriptors[i] = describeProperty(property[i], name[i].c_str(), Permission::ReadWrite);
+  }
+  /* Registering the same name twice keeps the first property */
+  CloudInt duplicate;
+  descriptors[PROPERTY_COUNT] = describeProperty(duplicate, name[0].c_str(), Permission::ReadWrite).publishOnDemand();
+
+  addPropertiesToContainer(property_container, descriptors, PROPERTY_COUNT + 1);
+
+  REQUIRE(property_container.size() == PROPERTY_COUNT);
+  REQUIRE(getProperty(property_container, name[0]) == &property[0]);
+  REQUIRE_FALSE(duplicate.isDirty());
+
+  /* Properties without identifier are numbered in registration order */
+  for (size_t i = 0; i < PROPERTY_COUNT; i++) {
+    REQUIRE(property[i].identifier() == static_cast<int>(i + 1));
+    REQUIRE(getProperty(property_container, static_cast<int>(i + 1)) == &property[i]);
+  }
+}
@@ -0,0 +1,108 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdint.h>
+#include <iomanip>
+#include <iostream>
+
+#include <Property.h>
+#include <types/CloudBool.h>
+#include <types/CloudFloat.h>
+#include <types/CloudInt.h>
+#include <types/CloudUnsignedInt.h>
+#include <types/CloudString.h>
+#include <types/CloudLocation.h>
+#include <types/CloudColor.h>
+#include <types/CloudSchedule.h>
+#include <types/CloudWrapperBool.h>
+#include <types/CloudWrapperFloat.h>
+#include <types/CloudWrapperInt.h>
+#include <types/CloudWrapperUnsignedInt.h>
+#include <types/CloudWrapperString.h>
+#include <types/automation/CloudColoredLight.h>
+#include <types/automation/CloudContactSensor.h>
+#include <types/automation/CloudDimmedLight.h>
+#include <types/automation/CloudLight.h>
+#include <types/automation/CloudMotionSensor.h>
+#include <types/automation/CloudSmartPlug.h>
+#include <types/automation/CloudSwitch.h>
+#include <types/automation/CloudTelevision.h>
+#include <types/automation/CloudTemperatureSensor.h>
+
+/**************************************************************************************
+   FOOTPRINT BUDGET
+ **************************************************************************************/
+
+/* The RAM used by a thing is proportional to the number of its properties.
+ * On a 64 bit host Property may take 160 bytes, one word of headroom over its
+ * current layout which includes the link to its container (a pointer, two
+ * flags and a deadline, i.e. three words), the pointer to its name and the
+ * pointer to the SenML base fields of the message being encoded.
+ */
+static size_t const PROPERTY_FOOTPRINT_BUDGET = 160;
+
+/* A property type may only add the local and the cloud copy of its value to
+ * Property (and to the property type it derives from), plus the reference to
+ * the wrapped variable for the wrappers. These bounds are derived from
+ * sizeof(Property) and the members of each type and have no headroom on
+ * purpose: a new member has to be accounted for here.
+ */
+#define PROPERTY_FOOTPRINT_TABLE(X) \
+  X(CloudBool,               2 * sizeof(bool))                      \
+  X(CloudFloat,              2 * sizeof(float))                     \
+  X(CloudInt,                2 * sizeof(int))                       \
+  X(CloudUnsignedInt,        2 * sizeof(unsigned int))              \
+  X(CloudString,             2 * sizeof(String))                    \
+  X(CloudLocation,           2 * sizeof(Location))                  \
+  X(CloudColor,              2 * sizeof(Color))                     \
+  X(CloudSchedule,           2 * sizeof(Schedule))                  \
+  X(CloudWrapperBool,        sizeof(bool *) + 2 * sizeof(bool))     \
+  X(CloudWrapperFloat,       sizeof(float *) + 2 * sizeof(float))   \
+  X(CloudWrapperInt,         sizeof(int *) + 2 * sizeof(int))       \
+  X(CloudWrapperUnsignedInt, sizeof(unsigned int *) + 2 * sizeof(unsigned int)) \
+  X(CloudWrapperString,      sizeof(String *) + 2 * sizeof(String)) \
+  X(CloudColoredLight,       2 * sizeof(Color) + 2 * sizeof(ColoredLight)) \
+  X(CloudContactSensor,      2 * sizeof(bool))                      \
+  X(CloudDimmedLight,        2 * sizeof(DimmedLight))               \
+  X(CloudLight,              2 * sizeof(bool))                      \
+  X(CloudMotionSensor,       2 * sizeof(bool))                      \
+  X(CloudSmartPlug,          2 * sizeof(bool))                      \
+  X(CloudSwitch,             2 * sizeof(bool))                      \
+  X(CloudTelevision,         2 * sizeof(Television))                \
+  X(CloudTemperatureSensor,  2 * sizeof(float))
+
+static constexpr size_t propertyFootprintBudget(size_t const value_size, size_t const alignment)
+{
+  return (sizeof(Property) + value_size + alignment - 1) / alignment * alignment;
+}
+
+#if UINTPTR_MAX == 0xFFFFFFFFFFFFFFFFu
+static_assert(sizeof(Property) <= PROPERTY_FOOTPRINT_BUDGET, "sizeof(Property) exceeds its footprint budget");
+#endif
+
+#define CHECK_PROPERTY_FOOTPRINT(type, value_size) \
+  static_assert(sizeof(type) <= propertyFootprintBudget(value_size, alignof(type)), "sizeof(" #type ") exceeds its footprint budget");
+PROPERTY_FOOTPRINT_TABLE(CHECK_PROPERTY_FOOTPRINT)
+#undef CHECK_PROPERTY_FOOTPRINT
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+/* Hidden test case: run 'testArduinoIoTCloud [footprint]' to print the report */
+SCENARIO("Report the memory footprint of every property type", "[.][footprint]")
+{
+  std::cout << std::left << std::setw(24) << "Property" << std::right << std::setw(6) << sizeof(Property) << " / " << PROPERTY_FOOTPRINT_BUDGET << std::endl;
+#define PRINT_PROPERTY_FOOTPRINT(type, value_size) \
+  std::cout << std::left << std::setw(24) << #type << std::right << std::setw(6) << sizeof(type) << " / " << propertyFootprintBudget(value_size, alignof(type)) << std::endl;
+  PROPERTY_FOOTPRINT_TABLE(PRINT_PROPERTY_FOOTPRINT)
+#undef PRINT_PROPERTY_FOOTPRINT
+  SUCCEED();
+}
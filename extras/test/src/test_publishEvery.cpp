@@ -32,6 +32,7 @@ SCENARIO("A Arduino cloud property is published periodically", "[ArduinoCloudThi
         set_millis(999);
         THEN("'encode' should not encode the property") {
           REQUIRE(cbor::encode(property_container).size() == 0);
+          REQUIRE_FALSE(property_container.hasDirtyProperties());
           WHEN("t = 1000 ms") {
             set_millis(1000);
             THEN("'encode' should encode the property") {
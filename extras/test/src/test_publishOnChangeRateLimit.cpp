@@ -59,3 +59,32 @@ SCENARIO("An Arduino cloud property is published on value change but the update
     }
   }
 }
+
+SCENARIO("A rate limited Arduino cloud property is published once the minimum time between updates has elapsed", "[ArduinoCloudThing::publishOnChange]")
+{
+  PropertyContainer property_container;
+
+  CloudInt test = 0;
+  unsigned long const MIN_TIME_BETWEEN_UPDATES_ms = 500;
+
+  addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(0, MIN_TIME_BETWEEN_UPDATES_ms);
+
+  set_millis(0);
+  REQUIRE(cbor::encode(property_container).size() != 0);
+
+  WHEN("t = 100 ms, property modified") {
+    test++;
+    set_millis(100);
+    THEN("'encode' should not encode the property and the property waits for its deadline") {
+      REQUIRE(cbor::encode(property_container).size() == 0);
+      REQUIRE_FALSE(property_container.hasDirtyProperties());
+      WHEN("t = 500 ms, property not modified again") {
+        set_millis(500);
+        THEN("'encode' should encode the property") {
+          REQUIRE(cbor::encode(property_container).size() != 0);
+          REQUIRE_FALSE(property_container.hasDirtyProperties());
+        }
+      }
+    }
+  }
+}
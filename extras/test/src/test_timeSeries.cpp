@@ -0,0 +1,133 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <util/CBORTestUtil.h>
+
+#include <CBOREncoder.h>
+#include <PropertyContainer.h>
+
+/**************************************************************************************
+   LOCAL FUNCTIONS
+ **************************************************************************************/
+
+static unsigned long getTestTime()
+{
+  return 1000;
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("A time series property sends all the samples recorded since the last update", "[CloudTimeSeries]")
+{
+  PropertyContainer property_container;
+
+  CloudTimeSeries<int, 4> series;
+  addPropertyToContainer(property_container, series, "test", Permission::ReadWrite, -1, getTestTime);
+
+  set_millis(0);
+
+  WHEN("No sample has been recorded")
+  {
+    THEN("The property is encoded as a plain property")
+    {
+      /* [{0: "test", 2: 0}] = 9F A2 00 64 74 65 73 74 02 00 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x00, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+    }
+  }
+
+  WHEN("Samples have been recorded at t = 2000 ms, 2500 ms and 3200 ms")
+  {
+    set_millis(2000); series = 1;
+    set_millis(2500); series = 2;
+    set_millis(3200); series = 3;
+    REQUIRE(series.samples() == 3);
+
+    THEN("Every sample is encoded with its absolute time")
+    {
+      /* [{0: "test", 2: 1, 6: 1000}, {0: "test", 2: 2, 6: 1000.5}, {0: "test", 2: 3, 6: 1001.2000000476837}]
+       * = 9F A3 00 64 74 65 73 74 02 01 06 19 03 E8 A3 00 64 74 65 73 74 02 02 06 FB 40 8F 44 00 00 00 00 00 A3 00 64 74 65 73 74 02 03 06 FB 40 8F 49 99 99 A0 00 00 FF
+       */
+      std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x01, 0x06, 0x19, 0x03, 0xE8,
+                                             0xA3, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x02, 0x06, 0xFB, 0x40, 0x8F, 0x44, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                             0xA3, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x03, 0x06, 0xFB, 0x40, 0x8F, 0x49, 0x99, 0x99, 0xA0, 0x00, 0x00, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+      REQUIRE(series.samples() == 0);
+    }
+
+    THEN("With SenML base compression the samples share the base name and the base time")
+    {
+      /* [{-2: "test", -3: 1000, 2: 1}, {2: 2, 6: 0.5}, {2: 3, 6: 1.2000000476837158}]
+       * = 9F A3 21 64 74 65 73 74 22 19 03 E8 02 01 A2 02 02 06 FA 3F 00 00 00 A2 02 03 06 FA 3F 99 99 9A FF
+       */
+      std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x21, 0x64, 0x74, 0x65, 0x73, 0x74, 0x22, 0x19, 0x03, 0xE8, 0x02, 0x01,
+                                             0xA2, 0x02, 0x02, 0x06, 0xFA, 0x3F, 0x00, 0x00, 0x00,
+                                             0xA2, 0x02, 0x03, 0x06, 0xFA, 0x3F, 0x99, 0x99, 0x9A, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container, false, true);
+      REQUIRE(actual == expected);
+      REQUIRE(series.samples() == 0);
+    }
+
+    THEN("Samples not fitting into the message are kept for the next one")
+    {
+      uint8_t buf[32] = {0};
+      int bytes_encoded = 0;
+      unsigned int current_property_index = 0;
+
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      REQUIRE(bytes_encoded == 15);
+      REQUIRE(series.samples() == 2);
+    }
+  }
+
+  WHEN("The value is changed with the increment and compound assignment operators")
+  {
+    set_millis(1000); series = 1;
+    set_millis(2000); series++;
+    set_millis(3000); ++series;
+    set_millis(4000); series += 5;
+
+    THEN("Every change is recorded as a sample")
+    {
+      REQUIRE(series.samples() == 4);
+      std::vector<uint8_t> const actual = cbor::encode(property_container, false, true);
+      /* [{-2: "test", -3: 1000, 2: 1}, {2: 2, 6: 1}, {2: 3, 6: 2}, {2: 8, 6: 3}] */
+      std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x21, 0x64, 0x74, 0x65, 0x73, 0x74, 0x22, 0x19, 0x03, 0xE8, 0x02, 0x01,
+                                             0xA2, 0x02, 0x02, 0x06, 0x01,
+                                             0xA2, 0x02, 0x03, 0x06, 0x02,
+                                             0xA2, 0x02, 0x08, 0x06, 0x03, 0xFF};
+      REQUIRE(actual == expected);
+    }
+  }
+
+  WHEN("More samples than the buffer size have been recorded")
+  {
+    for (int i = 1; i <= 6; i++) {
+      set_millis(i * 1000);
+      series = i;
+    }
+
+    THEN("The oldest samples are overwritten")
+    {
+      REQUIRE(series.samples() == 4);
+      std::vector<uint8_t> const actual = cbor::encode(property_container, false, true);
+      /* [{-2: "test", -3: 1002, 2: 3}, {2: 4, 6: 1}, {2: 5, 6: 2}, {2: 6, 6: 3}] */
+      std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x21, 0x64, 0x74, 0x65, 0x73, 0x74, 0x22, 0x19, 0x03, 0xEA, 0x02, 0x03,
+                                             0xA2, 0x02, 0x04, 0x06, 0x01,
+                                             0xA2, 0x02, 0x05, 0x06, 0x02,
+                                             0xA2, 0x02, 0x06, 0x06, 0x03, 0xFF};
+      REQUIRE(actual == expected);
+    }
+  }
+}
@@ -24,13 +24,15 @@ namespace cbor
    PUBLIC FUNCTIONS
  **************************************************************************************/
 
-std::vector<uint8_t> encode(PropertyContainer & property_container, bool lightPayload)
+std::vector<uint8_t> encode(PropertyContainer & property_container, bool lightPayload, bool senmlBaseCompression, bool compactFloats)
 {
   int bytes_encoded = 0;
   unsigned int starting_property_index = 0;
   uint8_t buf[256] = {0};
 
-  if (CBOREncoder::encode(property_container, buf, 256, bytes_encoded, starting_property_index, lightPayload) == CborNoError)
+  /* Deadlines are checked once per update cycle before encoding */
+  property_container.markDueProperties(millis());
+  if (CBOREncoder::encode(property_container, buf, 256, bytes_encoded, starting_property_index, lightPayload, senmlBaseCompression, compactFloats) == CborNoError)
     return std::vector<uint8_t>(buf, buf + bytes_encoded);
   else
     return std::vector<uint8_t>();
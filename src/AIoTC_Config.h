@@ -34,6 +34,56 @@
   #define NTP_USE_RANDOM_PORT     (1)
 #endif
 
+/* Size of the static buffer holding the wrappers of primitive variables
+ * registered via addProperty(). If 0 wrappers are allocated on the heap.
+ */
+#ifndef AIOT_CONFIG_PROPERTY_ARENA_BYTES
+  #define AIOT_CONFIG_PROPERTY_ARENA_BYTES (0)
+#endif
+
+/* Encode property updates using the SenML base name and base time fields so
+ * that multi-value properties do not repeat their name for every attribute.
+ * Requires a broker accepting SenML base fields.
+ */
+#ifndef AIOT_CONFIG_SENML_BASE_COMPRESSION
+  #define AIOT_CONFIG_SENML_BASE_COMPRESSION (0)
+#endif
+
+/* Encode float values as integers when integral, or as half precision floats
+ * when this loses no more precision than the minimum delta of the property.
+ */
+#ifndef AIOT_CONFIG_COMPACT_FLOAT_ENCODING
+  #define AIOT_CONFIG_COMPACT_FLOAT_ENCODING (0)
+#endif
+
+/* Encode property updates sent over TCP and Notecard with the integer identifier
+ * of the property instead of its name, as done over LoRa. Every property must be
+ * registered with the identifier assigned to it by the cloud.
+ */
+#ifndef AIOT_CONFIG_LIGHT_PAYLOADS
+  #define AIOT_CONFIG_LIGHT_PAYLOADS (0)
+#endif
+
+/* Budget for sending property updates in several frames within a single
+ * update() call. Frames are sent until either the time or the byte budget
+ * is exhausted; if any of them is 0 one frame is sent per call.
+ */
+#ifndef AIOT_CONFIG_PROPERTY_BATCH_TIME_BUDGET_ms
+  #define AIOT_CONFIG_PROPERTY_BATCH_TIME_BUDGET_ms (0UL)
+#endif
+
+#ifndef AIOT_CONFIG_PROPERTY_BATCH_BYTE_BUDGET
+  #define AIOT_CONFIG_PROPERTY_BATCH_BYTE_BUDGET (0UL)
+#endif
+
+/* Size of the RAM buffer in which the property updates produced while the
+ * connection is down are stored, to be sent once it is up again. If 0 updates
+ * are only stored in the storage provided with setStoreAndForwardStorage().
+ */
+#ifndef AIOT_CONFIG_STORE_AND_FORWARD_RAM_SIZE
+  #define AIOT_CONFIG_STORE_AND_FORWARD_RAM_SIZE (0UL)
+#endif
+
 #ifndef DEBUG_ERROR
   #define DEBUG_ERROR(fmt, ...) Debug.print(DBG_ERROR, fmt, ## __VA_ARGS__)
 #endif
@@ -153,6 +203,49 @@
   #define BOARD_STM32H7
 #endif
 
+/* Size of the buffer holding an outgoing property frame, i.e. the largest frame
+ * which can be sent to the MQTT broker. Boards with plenty of RAM may send
+ * fewer, larger frames, see ArduinoIoTCloudTCP::setMaxPayloadSize().
+ */
+#ifndef AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE
+  #if defined(BOARD_STM32H7) || defined(ARDUINO_PORTENTA_C33) || defined(ARDUINO_ARCH_ESP32)
+    #define AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE (2048)
+  #else
+    #define AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE (256)
+  #endif
+#endif
+
+/* Size of the property frames sent to the MQTT broker unless a larger size is
+ * set with ArduinoIoTCloudTCP::setMaxPayloadSize(), and starting size of the
+ * frames in adaptive mode. Capped to AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE.
+ */
+#ifndef AIOT_CONFIG_MQTT_PAYLOAD_SIZE
+  #define AIOT_CONFIG_MQTT_PAYLOAD_SIZE (256)
+#endif
+
+/* In adaptive payload size mode a frame larger than any accepted before is
+ * considered accepted once the connection to the broker stayed open for this
+ * time after it has been sent. A broker rejecting a frame closes the
+ * connection, which the client only notices one round trip or more later.
+ */
+#ifndef AIOT_CONFIG_MQTT_PAYLOAD_PROBE_TIME_ms
+  #define AIOT_CONFIG_MQTT_PAYLOAD_PROBE_TIME_ms (5000UL)
+#endif
+
+/* Size of the buffer incoming messages are read into. Property updates are
+ * decoded while being received and only the records of a single property, i.e.
+ * its attributes, must fit. Commands other than the last values must fit entirely.
+ * With a size of 0 incoming messages are read into the transmit buffer, which
+ * saves the RAM of a separate buffer on boards with little of it.
+ */
+#ifndef AIOT_CONFIG_MQTT_RECEIVE_BUFFER_SIZE
+  #if defined(BOARD_STM32H7) || defined(ARDUINO_PORTENTA_C33) || defined(ARDUINO_ARCH_ESP32)
+    #define AIOT_CONFIG_MQTT_RECEIVE_BUFFER_SIZE (2048)
+  #else
+    #define AIOT_CONFIG_MQTT_RECEIVE_BUFFER_SIZE (0)
+  #endif
+#endif
+
 /******************************************************************************
  * CONSTANTS
  ******************************************************************************/
@@ -63,126 +63,156 @@ void ArduinoIoTCloudClass::addCallback(ArduinoIoTCloudEvent const event, OnCloud
 }
 
 /* The following methods are used for non-LoRa boards */
-Property& ArduinoIoTCloudClass::addPropertyReal(bool& property, String name, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(bool& property, PropertyName const & name, Permission const permission)
 {
   return addPropertyReal(property, name, -1, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(float& property, String name, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(float& property, PropertyName const & name, Permission const permission)
 {
   return addPropertyReal(property, name, -1, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(int& property, String name, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(int& property, PropertyName const & name, Permission const permission)
 {
   return addPropertyReal(property, name, -1, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, String name, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, PropertyName const & name, Permission const permission)
 {
   return addPropertyReal(property, name, -1, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(String& property, String name, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(String& property, PropertyName const & name, Permission const permission)
 {
   return addPropertyReal(property, name, -1, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(Property& property, String name, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(Property& property, PropertyName const & name, Permission const permission)
 {
   return addPropertyReal(property, name, -1, permission);
 }
 
 /* The following methods are used for both LoRa and non-Lora boards */
-Property& ArduinoIoTCloudClass::addPropertyReal(bool& property, String name, int tag, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(bool& property, PropertyName const & name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperBool(property);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperBool>(property, name);
+  if (p == nullptr)
+    return unregisteredProperty();
   return addPropertyReal(*p, name, tag, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(float& property, String name, int tag, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(float& property, PropertyName const & name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperFloat(property);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperFloat>(property, name);
+  if (p == nullptr)
+    return unregisteredProperty();
   return addPropertyReal(*p, name, tag, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(int& property, String name, int tag, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(int& property, PropertyName const & name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperInt(property);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperInt>(property, name);
+  if (p == nullptr)
+    return unregisteredProperty();
   return addPropertyReal(*p, name, tag, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, String name, int tag, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, PropertyName const & name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperUnsignedInt(property);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperUnsignedInt>(property, name);
+  if (p == nullptr)
+    return unregisteredProperty();
   return addPropertyReal(*p, name, tag, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(String& property, String name, int tag, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(String& property, PropertyName const & name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperString(property);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperString>(property, name);
+  if (p == nullptr)
+    return unregisteredProperty();
   return addPropertyReal(*p, name, tag, permission);
 }
-Property& ArduinoIoTCloudClass::addPropertyReal(Property& property, String name, int tag, Permission const permission)
+Property& ArduinoIoTCloudClass::addPropertyReal(Property& property, PropertyName const & name, int tag, Permission const permission)
 {
+  if (!isPropertyNameValid(name))
+    return unregisteredProperty();
   return addPropertyToContainer(getThingPropertyContainer(), property, name, permission, tag);
 }
 
+void ArduinoIoTCloudClass::addProperties(PropertyDescriptor const * descriptors, size_t const count)
+{
+  addPropertiesToContainer(getThingPropertyContainer(), descriptors, count);
+}
+
 /* The following methods are deprecated but still used for non-LoRa boards */
-void ArduinoIoTCloudClass::addPropertyReal(bool& property, String name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(bool& property, PropertyName const & name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperBool(property);
-  addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperBool>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(float& property, String name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(float& property, PropertyName const & name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperFloat(property);
-  addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperFloat>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(int& property, String name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(int& property, PropertyName const & name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperInt(property);
-  addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperInt>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, String name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, PropertyName const & name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperUnsignedInt(property);
-  addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperUnsignedInt>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(String& property, String name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(String& property, PropertyName const & name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperString(property);
-  addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperString>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, -1, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(Property& property, String name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(Property& property, PropertyName const & name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
   addPropertyRealInternal(property, name, -1, permission_type, seconds, fn, minDelta, synFn);
 }
 
 /* The following methods are deprecated but still used for both LoRa and non-LoRa boards */
-void ArduinoIoTCloudClass::addPropertyReal(bool& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(bool& property, PropertyName const & name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperBool(property);
-  addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperBool>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(float& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(float& property, PropertyName const & name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperFloat(property);
-  addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperFloat>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(int& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(int& property, PropertyName const & name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperInt(property);
-  addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperInt>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, PropertyName const & name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperUnsignedInt(property);
-  addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperUnsignedInt>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(String& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(String& property, PropertyName const & name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperString(property);
-  addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
+  Property* p = findOrCreatePropertyWrapper<CloudWrapperString>(property, name);
+  if (p != nullptr)
+    addPropertyRealInternal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
-void ArduinoIoTCloudClass::addPropertyReal(Property& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyReal(Property& property, PropertyName const & name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
   addPropertyRealInternal(property, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
 
-void ArduinoIoTCloudClass::addPropertyRealInternal(Property& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
+void ArduinoIoTCloudClass::addPropertyRealInternal(Property& property, PropertyName const & name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
+  if (!isPropertyNameValid(name))
+    return;
+
   Permission permission = Permission::ReadWrite;
   if (permission_type == READ) {
     permission = Permission::Read;
@@ -199,6 +229,58 @@ void ArduinoIoTCloudClass::addPropertyRealInternal(Property& property, String na
   }
 }
 
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+template <typename WrapperType, typename ValueType>
+Property * ArduinoIoTCloudClass::findOrCreatePropertyWrapper(ValueType & value, PropertyName const & name)
+{
+  /* A name registered before is configured again: no wrapper is allocated for it */
+  Property * p = getProperty(getThingPropertyContainer(), name);
+  if (p != nullptr)
+    return p;
+
+  if (!isPropertyNameValid(name))
+    return nullptr;
+
+  p = createPropertyWrapper<WrapperType>(value);
+  if (p == nullptr) {
+#if AIOT_CONFIG_PROPERTY_ARENA_BYTES > 0
+    DEBUG_ERROR("ArduinoIoTCloudClass::%s property arena full, \"%s\" not registered: %u bytes needed", __FUNCTION__, name.c_str(), static_cast<unsigned int>(PropertyWrapperArena.highWaterMark()));
+#else
+    DEBUG_ERROR("ArduinoIoTCloudClass::%s out of memory, \"%s\" not registered", __FUNCTION__, name.c_str());
+#endif
+  }
+  return p;
+}
+
+bool ArduinoIoTCloudClass::isPropertyNameValid(PropertyName const & name)
+{
+  if (name.length() <= Property::MAX_NAME_LENGTH)
+    return true;
+
+  DEBUG_ERROR("ArduinoIoTCloudClass::%s \"%s\" not registered: names are limited to %u characters", __FUNCTION__, name.c_str(), static_cast<unsigned int>(Property::MAX_NAME_LENGTH));
+  return false;
+}
+
+Property & ArduinoIoTCloudClass::unregisteredProperty()
+{
+  /* Returned in place of a property which could not be registered so that
+   * chained configuration calls in the sketch remain valid. It is created
+   * anew on every call so that the configuration of a failed registration
+   * does not carry over to the next one.
+   */
+  static bool value = false;
+  alignas(CloudWrapperBool) static uint8_t placeholder_buf[sizeof(CloudWrapperBool)];
+  static CloudWrapperBool * placeholder = nullptr;
+
+  if (placeholder != nullptr)
+    placeholder->~CloudWrapperBool();
+  placeholder = new (placeholder_buf) CloudWrapperBool(value);
+  return *placeholder;
+}
+
 /******************************************************************************
  * PROTECTED MEMBER FUNCTIONS
  ******************************************************************************/
@@ -36,6 +36,7 @@
 
 #include "property/Property.h"
 #include "property/PropertyContainer.h"
+#include "property/PropertyArena.h"
 #include "property/types/CloudWrapperBool.h"
 #include "property/types/CloudWrapperFloat.h"
 #include "property/types/CloudWrapperInt.h"
@@ -109,19 +110,26 @@ class ArduinoIoTCloudClass
      * name of the property to identify a given property within a CBOR message.
      */
 
-    void addPropertyReal(Property& property, String name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(bool& property, String name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(float& property, String name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(int& property, String name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(unsigned int& property, String name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(String& property, String name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-
-    Property& addPropertyReal(Property& property, String name, Permission const permission);
-    Property& addPropertyReal(bool& property, String name, Permission const permission);
-    Property& addPropertyReal(float& property, String name, Permission const permission);
-    Property& addPropertyReal(int& property, String name, Permission const permission);
-    Property& addPropertyReal(unsigned int& property, String name, Permission const permission);
-    Property& addPropertyReal(String& property, String name, Permission const permission);
+    void addPropertyReal(Property& property, PropertyName const & name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(bool& property, PropertyName const & name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(float& property, PropertyName const & name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(int& property, PropertyName const & name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(unsigned int& property, PropertyName const & name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(String& property, PropertyName const & name, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+
+    Property& addPropertyReal(Property& property, PropertyName const & name, Permission const permission);
+    Property& addPropertyReal(bool& property, PropertyName const & name, Permission const permission);
+    Property& addPropertyReal(float& property, PropertyName const & name, Permission const permission);
+    Property& addPropertyReal(int& property, PropertyName const & name, Permission const permission);
+    Property& addPropertyReal(unsigned int& property, PropertyName const & name, Permission const permission);
+    Property& addPropertyReal(String& property, PropertyName const & name, Permission const permission);
+
+    /* Registers all the properties described by a compile time table, see
+     * PropertyDescriptor.h.
+     */
+    void addProperties(PropertyDescriptor const * descriptors, size_t const count);
+    template <size_t N>
+    inline void addProperties(PropertyDescriptor const (&descriptors)[N]) { addProperties(descriptors, N); }
 
     /* The following methods are for MKR WAN 1300/1310 LoRa boards since
      * they use a number to identify a given property within a CBOR message.
@@ -129,19 +137,19 @@ class ArduinoIoTCloudClass
      * important when using LoRa.
      */
 
-    void addPropertyReal(Property& property, String name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(bool& property, String name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(float& property, String name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(int& property, String name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(unsigned int& property, String name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
-    void addPropertyReal(String& property, String name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(Property& property, PropertyName const & name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(bool& property, PropertyName const & name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(float& property, PropertyName const & name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(int& property, PropertyName const & name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(unsigned int& property, PropertyName const & name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
+    void addPropertyReal(String& property, PropertyName const & name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS) __attribute__((deprecated("Use addProperty(property, Permission::ReadWrite) instead.")));
 
-    Property& addPropertyReal(Property& property, String name, int tag, Permission const permission);
-    Property& addPropertyReal(bool& property, String name, int tag, Permission const permission);
-    Property& addPropertyReal(float& property, String name, int tag, Permission const permission);
-    Property& addPropertyReal(int& property, String name, int tag, Permission const permission);
-    Property& addPropertyReal(unsigned int& property, String name, int tag, Permission const permission);
-    Property& addPropertyReal(String& property, String name, int tag, Permission const permission);
+    Property& addPropertyReal(Property& property, PropertyName const & name, int tag, Permission const permission);
+    Property& addPropertyReal(bool& property, PropertyName const & name, int tag, Permission const permission);
+    Property& addPropertyReal(float& property, PropertyName const & name, int tag, Permission const permission);
+    Property& addPropertyReal(int& property, PropertyName const & name, int tag, Permission const permission);
+    Property& addPropertyReal(unsigned int& property, PropertyName const & name, int tag, Permission const permission);
+    Property& addPropertyReal(String& property, PropertyName const & name, int tag, Permission const permission);
 
   protected:
 
@@ -156,7 +164,15 @@ class ArduinoIoTCloudClass
 
     virtual PropertyContainer &getThingPropertyContainer() = 0;
 
-    void addPropertyRealInternal(Property& property, String name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS);
+    void addPropertyRealInternal(Property& property, PropertyName const & name, int tag, permissionType permission_type = READWRITE, long seconds = ON_CHANGE, void(*fn)(void) = NULL, float minDelta = 0.0f, void(*synFn)(Property & property) = CLOUD_WINS);
+    /* Returns the property already registered under name or a new wrapper of
+     * value, nullptr if no memory is left for the wrapper.
+     */
+    template <typename WrapperType, typename ValueType>
+    Property * findOrCreatePropertyWrapper(ValueType & value, PropertyName const & name);
+    /* Names too long to be encoded with their attributes are not registered */
+    static bool isPropertyNameValid(PropertyName const & name);
+    static Property & unregisteredProperty();
     String _device_id;
     OnCloudEventCallback _cloud_event_callback[3];
 };
@@ -151,7 +151,7 @@ void ArduinoIoTCloudLPWAN::sendPropertiesToCloud()
   int bytes_encoded = 0;
   uint8_t data[CBOR_LORA_MSG_MAX_SIZE];
 
-  if (CBOREncoder::encode(_thing_property_container, data, sizeof(data), bytes_encoded, _last_checked_property_index, true) == CborNoError)
+  if (CBOREncoder::encode(_thing_property_container, data, sizeof(data), bytes_encoded, _last_checked_property_index, true, false, AIOT_CONFIG_COMPACT_FLOAT_ENCODING) == CborNoError)
     if (bytes_encoded > 0)
       writeProperties(data, bytes_encoded);
 }
@@ -361,18 +361,10 @@ void ArduinoIoTCloudNotecard::processCommand(const uint8_t *buf, size_t len)
       {
         DEBUG_VERBOSE("ArduinoIoTCloudNotecard::%s [%d] last values received", __FUNCTION__, millis());
         CBORDecoder::decode(_thing.getPropertyContainer(),
-          (uint8_t*)command.lastValuesUpdateCmd.params.last_values,
+          command.lastValuesUpdateCmd.params.last_values,
           command.lastValuesUpdateCmd.params.length, true);
         _thing.handleMessage((Message*)&command);
         execCloudEventCallback(ArduinoIoTCloudEvent::SYNC);
-
-        /*
-         * NOTE: In this current version properties are not properly integrated
-         * with the new paradigm of modeling the messages with C structs. The
-         * current CBOR library allocates an array in the heap thus we need to
-         * delete it after decoding it with the old CBORDecoder
-         */
-        free(command.lastValuesUpdateCmd.params.last_values);
       }
       break;
 
@@ -455,7 +447,7 @@ void ArduinoIoTCloudNotecard::sendThingPropertyContainerToCloud()
   NotecardConnectionHandler *notecard_connection = reinterpret_cast<NotecardConnectionHandler *>(_connection);
 
   // Check if any property needs encoding and send them to the cloud
-  if (CBOREncoder::encode(_thing.getPropertyContainer(), data, sizeof(data), bytes_encoded, _thing.getPropertyContainerIndex(), USE_LIGHT_PAYLOADS) == CborNoError) {
+  if (CBOREncoder::encode(_thing.getPropertyContainer(), data, sizeof(data), bytes_encoded, _thing.getPropertyContainerIndex(), USE_LIGHT_PAYLOADS, AIOT_CONFIG_SENML_BASE_COMPRESSION, AIOT_CONFIG_COMPACT_FLOAT_ENCODING) == CborNoError) {
     if (static_cast<int>(CBOR_LORA_PAYLOAD_MAX_SIZE) < bytes_encoded) {
       DEBUG_ERROR("Encoded %d bytes for Thing properties. Exceeds maximum encoded payload size of %d bytes, and cannot sync with cloud.", bytes_encoded, CBOR_LORA_PAYLOAD_MAX_SIZE);
     } else if (bytes_encoded < 0) {
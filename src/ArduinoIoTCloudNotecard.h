@@ -23,7 +23,7 @@
  * DEFINES
  ******************************************************************************/
 
-#define USE_LIGHT_PAYLOADS (false)
+#define USE_LIGHT_PAYLOADS (AIOT_CONFIG_LIGHT_PAYLOADS)
 
 /******************************************************************************
  * CONSTANTS
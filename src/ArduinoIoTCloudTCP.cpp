@@ -51,11 +51,33 @@ ArduinoIoTCloudTCP::ArduinoIoTCloudTCP()
 : _state{State::ConnectPhy}
 , _connection_attempt(0,0)
 , _message_stream(std::bind(&ArduinoIoTCloudTCP::sendMessage, this, std::placeholders::_1))
+, _message_stream_stalled{false}
 , _thing(&_message_stream)
 , _device(&_message_stream)
 , _mqtt_data_buf{0}
+#if AIOT_CONFIG_MQTT_RECEIVE_BUFFER_SIZE > 0
+, _mqtt_receive_buf{_mqtt_receive_storage}
+, _mqtt_receive_buf_size{sizeof(_mqtt_receive_storage)}
+#else
+, _mqtt_receive_buf{_mqtt_data_buf}
+, _mqtt_receive_buf_size{sizeof(_mqtt_data_buf)}
+#endif
 , _mqtt_data_len{0}
 , _mqtt_data_request_retransmit{false}
+, _mqtt_payload_size{MQTT_DEFAULT_PAYLOAD_SIZE}
+, _mqtt_max_payload_size{MQTT_DEFAULT_PAYLOAD_SIZE}
+, _mqtt_accepted_payload_size{0}
+, _mqtt_probed_payload_size{0}
+, _mqtt_probe_millis{0}
+, _mqtt_adaptive_payload_size{false}
+, _batch_time_budget_ms{AIOT_CONFIG_PROPERTY_BATCH_TIME_BUDGET_ms}
+, _batch_byte_budget{AIOT_CONFIG_PROPERTY_BATCH_BYTE_BUDGET}
+#if AIOT_CONFIG_STORE_AND_FORWARD_RAM_SIZE > 0
+, _store_and_forward_ram{_store_and_forward_buf, sizeof(_store_and_forward_buf)}
+, _store_and_forward_storage{&_store_and_forward_ram}
+#else
+, _store_and_forward_storage{nullptr}
+#endif
 #ifdef BOARD_HAS_SECRET_KEY
 , _password("")
 #endif
@@ -173,6 +195,7 @@ int ArduinoIoTCloudTCP::begin(bool const enable_watchdog, String brokerAddress,
 
   _thing.begin();
   _device.begin();
+  _store_and_forward_queue.begin(_store_and_forward_storage);
 
 #if OTA_ENABLED && !defined(OFFLOADED_DOWNLOAD)
   _ota.setClient(&_otaClient);
@@ -233,6 +256,10 @@ void ArduinoIoTCloudTCP::update()
   }
   _state = next_state;
 
+  /* Keep the property updates produced while disconnected for later */
+  if ((_state != State::Connected) && _store_and_forward_queue.isEnabled())
+    storePropertyContainer(_thing.getPropertyContainer());
+
   /* This watchdog feed is actually needed only by the RP2040 Connect because its
    * maximum watchdog window is 8389 ms; despite this we feed it for all
    * supported ARCH to keep code aligned.
@@ -258,6 +285,10 @@ void ArduinoIoTCloudTCP::update()
     _ota.approveOta();
   }
 #endif // OTA_ENABLED
+
+  /* Messages delivered by the processes are sent once they have all run */
+  if (_state == State::Connected)
+    sendQueuedMessages();
 }
 
 int ArduinoIoTCloudTCP::connected()
@@ -265,11 +296,24 @@ int ArduinoIoTCloudTCP::connected()
   return _mqttClient.connected();
 }
 
+void ArduinoIoTCloudTCP::setMaxPayloadSize(size_t const max_size, bool const adaptive)
+{
+  _mqtt_max_payload_size = std::min(max_size, static_cast<size_t>(MQTT_TRANSMIT_BUFFER_SIZE));
+  _mqtt_adaptive_payload_size = adaptive;
+  _mqtt_payload_size = adaptive ? std::min(_mqtt_max_payload_size, static_cast<size_t>(MQTT_DEFAULT_PAYLOAD_SIZE)) : _mqtt_max_payload_size;
+  _mqtt_accepted_payload_size = 0;
+  _mqtt_probed_payload_size = 0;
+}
+
 void ArduinoIoTCloudTCP::printDebugInfo()
 {
   DEBUG_INFO("***** Arduino IoT Cloud - %s *****", AIOT_CONFIG_LIB_VERSION);
   DEBUG_INFO("Device ID: %s", getDeviceId().c_str());
   DEBUG_INFO("MQTT Broker: %s:%d", _brokerAddress.c_str(), _brokerPort);
+  DEBUG_INFO("MQTT payload size: %u/%u bytes%s", static_cast<unsigned int>(_mqtt_payload_size), static_cast<unsigned int>(_mqtt_max_payload_size), _mqtt_adaptive_payload_size ? " (adaptive)" : "");
+#if AIOT_CONFIG_PROPERTY_ARENA_BYTES > 0
+  DEBUG_INFO("Property arena: %u/%u bytes, high-water mark %u bytes", static_cast<unsigned int>(PropertyWrapperArena.used()), static_cast<unsigned int>(PropertyWrapperArena.capacity()), static_cast<unsigned int>(PropertyWrapperArena.highWaterMark()));
+#endif
 }
 
 /******************************************************************************
@@ -337,6 +381,8 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_ConnectMqttBroker()
 
 ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Connected()
 {
+  adaptPayloadSize(_mqttClient.connected());
+
   if (!_mqttClient.connected() || !_thing.connected() || !_device.connected())
   {
     return State::Disconnect;
@@ -358,6 +404,10 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Connected()
 
 
   if (_device.isAttached()) {
+    /* Property updates stored while disconnected are sent first */
+    if (!_store_and_forward_queue.empty())
+      sendStoredProperties();
+
     /* Call CloudThing process to synchronize properties */
     _thing.update();
   }
@@ -374,6 +424,9 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Disconnect()
     _mqttClient.stop();
   }
 
+  /* Messages of the previous session are obsolete */
+  _message_stream.clear();
+
   Message message = { ResetCmdId };
   _thing.handleMessage(&message);
   _device.handleMessage(&message);
@@ -394,16 +447,22 @@ void ArduinoIoTCloudTCP::onMessage(int length)
 void ArduinoIoTCloudTCP::handleMessage(int length)
 {
   String topic = _mqttClient.messageTopic();
+  size_t const message_length = static_cast<size_t>(length);
 
-  byte bytes[length];
-
-  for (int i = 0; i < length; i++) {
-    bytes[i] = _mqttClient.read();
+  /* A receive buffer shared with the transmit buffer overwrites the last frame sent */
+  if (_mqtt_receive_buf == _mqtt_data_buf) {
+    _mqtt_data_len = 0;
   }
 
   /* Topic for user input data */
   if (_dataTopicIn == topic) {
-    CBORDecoder::decode(_thing.getPropertyContainer(), (uint8_t*)bytes, length);
+    CBORDecoder decoder(_thing.getPropertyContainer(), _mqtt_receive_buf, _mqtt_receive_buf_size);
+    if (!readProperties(decoder, message_length)) {
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s [%d] could not decode %d bytes of properties", __FUNCTION__, millis(), length);
+    }
+  } else if (_messageTopicIn != topic) {
+    /* Messages of any other topic are discarded */
+    skipMessage(message_length);
   }
 
   /* Topic for device commands */
@@ -412,8 +471,34 @@ void ArduinoIoTCloudTCP::handleMessage(int length)
     DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] received %d bytes", __FUNCTION__, millis(), length);
     CBORMessageDecoder decoder;
 
-    size_t buffer_length = length;
-    if (decoder.decode((Message*)&command, bytes, buffer_length) != Decoder::Status::Error) {
+    size_t buffer_length = readMessage(_mqtt_receive_buf, std::min(message_length, _mqtt_receive_buf_size));
+
+    /* Last values exceeding the buffer are decoded while being received, the other commands are dropped */
+    if (message_length > _mqtt_receive_buf_size) {
+      size_t offset = 0, values_length = 0;
+      if (!decoder.findLastValues(_mqtt_receive_buf, buffer_length, offset, values_length) || (offset + values_length) > message_length) {
+        DEBUG_ERROR("ArduinoIoTCloudTCP::%s [%d] dropped command of %d bytes", __FUNCTION__, millis(), length);
+        skipMessage(message_length - buffer_length);
+        return;
+      }
+
+      DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] last values received", __FUNCTION__, millis());
+      /* The part of the last values already read is moved to the front of the buffer */
+      CBORDecoder values_decoder(_thing.getPropertyContainer(), _mqtt_receive_buf, _mqtt_receive_buf_size, true);
+      size_t room = 0;
+      size_t const values_read = std::min(buffer_length - offset, values_length);
+      memmove(values_decoder.reserve(room), _mqtt_receive_buf + offset, values_read);
+      values_decoder.commit(values_read);
+      readProperties(values_decoder, values_length - values_read);
+      skipMessage(message_length - buffer_length - (values_length - values_read));
+
+      command.c.id = CommandId::LastValuesUpdateCmdId;
+      _thing.handleMessage((Message*)&command);
+      execCloudEventCallback(ArduinoIoTCloudEvent::SYNC);
+      return;
+    }
+
+    if (decoder.decode((Message*)&command, _mqtt_receive_buf, buffer_length) != Decoder::Status::Error) {
       DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] received command id %d", __FUNCTION__, millis(), command.c.id);
       switch (command.c.id)
       {
@@ -461,17 +546,10 @@ void ArduinoIoTCloudTCP::handleMessage(int length)
         {
           DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] last values received", __FUNCTION__, millis());
           CBORDecoder::decode(_thing.getPropertyContainer(),
-            (uint8_t*)command.lastValuesUpdateCmd.params.last_values,
+            command.lastValuesUpdateCmd.params.last_values,
             command.lastValuesUpdateCmd.params.length, true);
           _thing.handleMessage((Message*)&command);
           execCloudEventCallback(ArduinoIoTCloudEvent::SYNC);
-
-          /*
-           * NOTE: in this current version properties are not properly integrated with the new paradigm of
-           * modeling the messages with C structs. The current CBOR library allocates an array in the heap
-           * thus we need to delete it after decoding it with the old CBORDecoder
-           */
-          free(command.lastValuesUpdateCmd.params.last_values);
         }
         break;
 
@@ -481,18 +559,76 @@ void ArduinoIoTCloudTCP::handleMessage(int length)
           DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] ota update received", __FUNCTION__, millis());
           _ota.handleMessage((Message*)&command);
         }
+        break;
 #endif
 
         default:
+        {
+          DEBUG_WARNING("ArduinoIoTCloudTCP::%s [%d] dropped unsupported command id %d", __FUNCTION__, millis(), command.c.id);
+        }
         break;
       }
+    } else {
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s [%d] dropped undecodable command of %d bytes", __FUNCTION__, millis(), length);
+    }
+  }
+}
+
+size_t ArduinoIoTCloudTCP::readMessage(uint8_t * data, size_t const length)
+{
+  size_t bytes_read = 0;
+  while (bytes_read < length) {
+    int const chunk_length = _mqttClient.read(data + bytes_read, length - bytes_read);
+    if (chunk_length <= 0) {
+      break;
+    }
+    bytes_read += chunk_length;
+  }
+  return bytes_read;
+}
+
+bool ArduinoIoTCloudTCP::readProperties(CBORDecoder & decoder, size_t length)
+{
+  /* Chunks are read straight into the buffer of the decoder, which decodes the
+   * records completed so far and drops them to make room for the next chunk.
+   */
+  while (length > 0) {
+    size_t room = 0;
+    uint8_t * chunk = decoder.reserve(room);
+    if (room == 0) {
+      break;
+    }
+
+    int const chunk_length = _mqttClient.read(chunk, std::min(room, length));
+    if (chunk_length <= 0) {
+      break;
+    }
+
+    length -= chunk_length;
+    if (!decoder.commit(chunk_length)) {
+      break;
+    }
+  }
+
+  skipMessage(length);
+  return decoder.isComplete();
+}
+
+void ArduinoIoTCloudTCP::skipMessage(size_t length)
+{
+  /* The bytes of the message left unread are discarded */
+  while (length > 0) {
+    int const chunk_length = _mqttClient.read(_mqtt_receive_buf, std::min(length, _mqtt_receive_buf_size));
+    if (chunk_length <= 0) {
+      break;
     }
+    length -= chunk_length;
   }
 }
 
-void ArduinoIoTCloudTCP::sendMessage(Message * msg)
+bool ArduinoIoTCloudTCP::sendMessage(Message * msg)
 {
-  uint8_t data[MQTT_TRANSMIT_BUFFER_SIZE];
+  uint8_t data[MQTT_COMMAND_BUFFER_SIZE];
   size_t bytes_encoded = sizeof(data);
   CBORMessageEncoder encoder;
 
@@ -501,7 +637,6 @@ void ArduinoIoTCloudTCP::sendMessage(Message * msg)
       return sendPropertyContainerToCloud(_dataTopicOut,
                                           _thing.getPropertyContainer(),
                                           _thing.getPropertyContainerIndex());
-      break;
 
     default:
       break;
@@ -509,29 +644,190 @@ void ArduinoIoTCloudTCP::sendMessage(Message * msg)
 
   if (encoder.encode(msg, data, bytes_encoded) == Encoder::Status::Complete &&
       bytes_encoded > 0) {
-    write(_messageTopicOut, data, bytes_encoded);
-  } else {
-    DEBUG_ERROR("error encoding %d", msg->id);
+    return write(_messageTopicOut, data, bytes_encoded);
   }
+
+  /* A message which cannot be encoded is dropped */
+  DEBUG_ERROR("error encoding %d", msg->id);
+  return true;
 }
 
-void ArduinoIoTCloudTCP::sendPropertyContainerToCloud(String const topic, PropertyContainer & property_container, unsigned int & current_property_index)
+void ArduinoIoTCloudTCP::sendQueuedMessages()
+{
+  /* A message which cannot be written stays at the head of the queue and is
+   * retried by the next update(), the following ones wait behind it.
+   */
+  _message_stream.flush();
+
+  /* A stalled queue is reported once, not on every update() */
+  if (_message_stream.empty()) {
+    _message_stream_stalled = false;
+  } else if (!_message_stream_stalled) {
+    _message_stream_stalled = true;
+    DEBUG_WARNING("ArduinoIoTCloudTCP::%s could not send message %u, %u pending", __FUNCTION__, static_cast<unsigned int>(_message_stream.front()->id), static_cast<unsigned int>(_message_stream.size()));
+  }
+}
+
+void ArduinoIoTCloudTCP::probePayloadSize(size_t const frame_size)
+{
+  /* A frame larger than any accepted so far is confirmed once the connection
+   * stayed open for the probe time, which restarts with every larger frame.
+   */
+  if (_mqtt_adaptive_payload_size && (frame_size > _mqtt_accepted_payload_size) && (frame_size > _mqtt_probed_payload_size))
+  {
+    _mqtt_probed_payload_size = frame_size;
+    _mqtt_probe_millis = millis();
+  }
+}
+
+void ArduinoIoTCloudTCP::adaptPayloadSize(bool const connected)
+{
+  if (!_mqtt_adaptive_payload_size || (_mqtt_probed_payload_size == 0))
+    return;
+
+  if (connected)
+  {
+    /* A rejected frame makes the broker close the connection, which is noticed
+     * one round trip or more after the write: wait before accepting the frame.
+     */
+    if ((millis() - _mqtt_probe_millis) < AIOT_CONFIG_MQTT_PAYLOAD_PROBE_TIME_ms)
+      return;
+
+    /* The broker kept the connection: the frame has been accepted. The frame size
+     * is doubled if the accepted frame was limited by it.
+     */
+    _mqtt_accepted_payload_size = _mqtt_probed_payload_size;
+    if ((_mqtt_accepted_payload_size * 2) > _mqtt_payload_size)
+      _mqtt_payload_size = std::min(_mqtt_payload_size * 2, _mqtt_max_payload_size);
+  }
+  else
+  {
+    /* The connection dropped after a larger frame: stop growing */
+    _mqtt_max_payload_size = std::max(_mqtt_accepted_payload_size, std::min(_mqtt_max_payload_size, static_cast<size_t>(MQTT_DEFAULT_PAYLOAD_SIZE)));
+    _mqtt_payload_size = _mqtt_max_payload_size;
+    DEBUG_WARNING("ArduinoIoTCloudTCP::%s connection lost after a %u bytes frame, frame size capped to %u bytes", __FUNCTION__, static_cast<unsigned int>(_mqtt_probed_payload_size), static_cast<unsigned int>(_mqtt_payload_size));
+  }
+
+  _mqtt_probed_payload_size = 0;
+}
+
+bool ArduinoIoTCloudTCP::sendPropertyContainerToCloud(String const topic, PropertyContainer & property_container, unsigned int & current_property_index)
 {
   int bytes_encoded = 0;
-  uint8_t data[MQTT_TRANSMIT_BUFFER_SIZE];
+  unsigned long const batch_start_millis = millis();
+  size_t bytes_sent = 0;
+
+  /* Without a budget only one frame is sent, otherwise frames are sent until all changed properties
+   * have been sent, or the budget is exhausted and the remaining ones are left for the next update().
+   */
+  bool const batching = (_batch_time_budget_ms > 0) && (_batch_byte_budget > 0);
 
-  if (CBOREncoder::encode(property_container, data, sizeof(data), bytes_encoded, current_property_index, false) == CborNoError)
+  do
   {
-    if (bytes_encoded > 0)
-    {
-      /* If properties have been encoded store them in the back-up buffer
-       * in order to allow retransmission in case of failure.
-       */
-      _mqtt_data_len = bytes_encoded;
-      memcpy(_mqtt_data_buf, data, _mqtt_data_len);
-      /* Transmit the properties to the MQTT broker */
-      write(topic, _mqtt_data_buf, _mqtt_data_len);
+    /* Properties are encoded straight into the back-up buffer, which is
+     * written to the MQTT client as is and kept in order to allow
+     * retransmission in case of failure. Pending retransmissions are
+     * handled before the thing is updated, hence the buffer is free.
+     * Only the last frame of a batch is kept, a failed write stops the batch.
+     */
+    _mqtt_data_len = 0;
+    if (CBOREncoder::encode(property_container, _mqtt_data_buf, _mqtt_payload_size, bytes_encoded, current_property_index, AIOT_CONFIG_LIGHT_PAYLOADS, AIOT_CONFIG_SENML_BASE_COMPRESSION, AIOT_CONFIG_COMPACT_FLOAT_ENCODING) != CborNoError)
+      return true;
+
+    if (bytes_encoded <= 0)
+      return true;
+
+    _mqtt_data_len = bytes_encoded;
+    /* Transmit the properties to the MQTT broker */
+    if (!write(topic, _mqtt_data_buf, _mqtt_data_len))
+      return false;
+
+    probePayloadSize(static_cast<size_t>(bytes_encoded));
+
+    bytes_sent += bytes_encoded;
+  } while (batching &&
+           (bytes_sent < _batch_byte_budget) &&
+           ((millis() - batch_start_millis) < _batch_time_budget_ms));
+
+  return true;
+}
+
+void ArduinoIoTCloudTCP::storePropertyContainer(PropertyContainer & property_container)
+{
+  /* Nothing to store before the thing has been attached once */
+  if (_dataTopicOut.length() == 0)
+    return;
+
+  updateTimestampOnLocallyChangedProperties(property_container);
+  if (!property_container.hasDirtyProperties())
+    return;
+
+  /* Every property due for an update is stored as a separate entry keyed by its
+   * index in the container, holding its records timestamped with the time of the
+   * change. The entry is encoded as an element of an array to be sent as is within
+   * a frame, leaving room for the bytes opening and closing the array.
+   */
+  uint8_t data[MQTT_DEFAULT_PAYLOAD_SIZE];
+  for (size_t i = 0; (i < property_container.size()) && property_container.hasDirtyProperties(); i++)
+  {
+    Property * p = property_container[i];
+    if (!p->isDirty() || !p->shouldBeUpdated() || !p->isReadableByCloud())
+      continue;
+
+    CborEncoder encoder, array_encoder;
+    cbor_encoder_init(&encoder, data, sizeof(data) - 1, 0);
+    cbor_encoder_create_array(&encoder, &array_encoder, CborIndefiniteLength);
+    if (p->encode(&array_encoder, AIOT_CONFIG_LIGHT_PAYLOADS, nullptr, AIOT_CONFIG_COMPACT_FLOAT_ENCODING, true) != CborNoError)
+      continue;
+
+    /* A full queue keeps the property dirty, its latest value is sent on reconnect.
+     * A stored property is throttled like a sent one, by its own update policy,
+     * and its append completes once the entry has been written to the cloud.
+     */
+    size_t const len = cbor_encoder_get_buffer_size(&array_encoder, data) - 1;
+    if (_store_and_forward_queue.push(static_cast<int32_t>(i), data + 1, len, !p->keepsHistory())) {
+      p->markStored();
+    }
+  }
+}
+
+void ArduinoIoTCloudTCP::sendStoredProperties()
+{
+  /* Stored entries are sent at once, as many per frame as fit, until the queue is
+   * empty or a write fails. Entries are removed from the queue once written.
+   */
+  PropertyContainer & property_container = _thing.getPropertyContainer();
+  while (!_store_and_forward_queue.empty())
+  {
+    size_t entries = 0;
+    size_t len = _store_and_forward_queue.peek(_mqtt_data_buf + 1, _mqtt_payload_size - 2, entries);
+    if (entries == 0) {
+      /* Entries are stored within the default frame size, an entry exceeding a smaller one is sent alone */
+      len = _store_and_forward_queue.peek(_mqtt_data_buf + 1, sizeof(_mqtt_data_buf) - 2, entries);
+    }
+    if (entries == 0) {
+      /* Stored with a larger buffer before a reset: the current value of the property is sent instead */
+      DEBUG_WARNING("ArduinoIoTCloudTCP::%s stored entry larger than the transmit buffer dropped", __FUNCTION__);
+      _store_and_forward_queue.pop(1, [&property_container](int32_t const key) {
+        if ((key >= 0) && (static_cast<size_t>(key) < property_container.size()))
+          property_container[key]->storeDropped();
+      });
+      continue;
     }
+
+    /* Entries are the elements of an indefinite length array */
+    _mqtt_data_buf[0] = 0x9F;
+    _mqtt_data_buf[len + 1] = 0xFF;
+    _mqtt_data_len = static_cast<int>(len + 2);
+    if (!write(_dataTopicOut, _mqtt_data_buf, _mqtt_data_len))
+      return;
+
+    probePayloadSize(static_cast<size_t>(_mqtt_data_len));
+
+    _store_and_forward_queue.pop(entries, [&property_container](int32_t const key) {
+      if ((key >= 0) && (static_cast<size_t>(key) < property_container.size()) && property_container[key]->isStored())
+        property_container[key]->appendCompleted();
+    });
   }
 }
 
@@ -27,6 +27,8 @@
 #include <ArduinoMqttClient.h>
 #include <ArduinoIoTCloudThing.h>
 #include <ArduinoIoTCloudDevice.h>
+#include <utility/queue/FrameQueue.h>
+#include <message/MessageQueue.h>
 
 #if defined(BOARD_HAS_SECURE_ELEMENT)
   #include <Arduino_SecureElement.h>
@@ -90,6 +92,35 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
 
     inline PropertyContainer &getThingPropertyContainer() { return _thing.getPropertyContainer(); }
 
+    /* Largest property frame sent to the broker, capped to AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE.
+     * Frames are limited to AIOT_CONFIG_MQTT_PAYLOAD_SIZE until this is called.
+     * In adaptive mode frames start at AIOT_CONFIG_MQTT_PAYLOAD_SIZE and grow up to max_size as
+     * long as the broker accepts them, i.e. the connection stays open for
+     * AIOT_CONFIG_MQTT_PAYLOAD_PROBE_TIME_ms after a frame larger than any accepted before.
+     * If the connection drops within that time the frame size is capped to the largest accepted one.
+     */
+    void setMaxPayloadSize(size_t const max_size, bool const adaptive = false);
+    inline size_t getPayloadSize() const { return _mqtt_payload_size; }
+
+    /* Changed properties exceeding a single frame are sent in several frames within the same
+     * update() call until max_time_ms elapsed or max_bytes have been sent. Passing 0 for any of
+     * the budgets restores the default behaviour of sending one frame per update() call.
+     */
+    inline void setPropertyBatchBudget(unsigned long const max_time_ms, size_t const max_bytes) {
+      _batch_time_budget_ms = max_time_ms;
+      _batch_byte_budget = max_bytes;
+    }
+
+    /* Property updates produced while the connection is down are stored in storage,
+     * e.g. a FileFrameQueueStorage on LittleFS to keep them across a reset, and sent
+     * with the time of the change on reconnect. A value not sent yet is superseded
+     * by a newer one of the same property, unless the property keeps its history
+     * (timestamped properties and CloudTimeSeries). Must be called before begin().
+     */
+    inline void setStoreAndForwardStorage(FrameQueueStorage & storage) {
+      _store_and_forward_storage = &storage;
+    }
+
 #if OTA_ENABLED
     /* The callback is triggered when the OTA is initiated and it gets executed until _ota_req flag is cleared.
      * It should return true when the OTA can be applied or false otherwise.
@@ -116,7 +147,9 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
 #endif
 
   private:
-    static const int MQTT_TRANSMIT_BUFFER_SIZE = 256;
+    static const int MQTT_TRANSMIT_BUFFER_SIZE = AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE;
+    static const int MQTT_COMMAND_BUFFER_SIZE = 256;
+    static const size_t MQTT_DEFAULT_PAYLOAD_SIZE = (AIOT_CONFIG_MQTT_PAYLOAD_SIZE < AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE) ? AIOT_CONFIG_MQTT_PAYLOAD_SIZE : AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE;
 
     enum class State
     {
@@ -129,15 +162,35 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
 
     State _state;
     TimedAttempt _connection_attempt;
-    MessageStream _message_stream;
+    MessageQueue _message_stream;
+    bool _message_stream_stalled;
     ArduinoCloudThing _thing;
     ArduinoCloudDevice _device;
 
     String _brokerAddress;
     uint16_t _brokerPort;
     uint8_t _mqtt_data_buf[MQTT_TRANSMIT_BUFFER_SIZE];
+#if AIOT_CONFIG_MQTT_RECEIVE_BUFFER_SIZE > 0
+    uint8_t _mqtt_receive_storage[AIOT_CONFIG_MQTT_RECEIVE_BUFFER_SIZE];
+#endif
+    uint8_t * const _mqtt_receive_buf;
+    size_t const _mqtt_receive_buf_size;
     int _mqtt_data_len;
     bool _mqtt_data_request_retransmit;
+    size_t _mqtt_payload_size;
+    size_t _mqtt_max_payload_size;
+    size_t _mqtt_accepted_payload_size;
+    size_t _mqtt_probed_payload_size;
+    unsigned long _mqtt_probe_millis;
+    bool _mqtt_adaptive_payload_size;
+    unsigned long _batch_time_budget_ms;
+    size_t _batch_byte_budget;
+#if AIOT_CONFIG_STORE_AND_FORWARD_RAM_SIZE > 0
+    uint8_t _store_and_forward_buf[AIOT_CONFIG_STORE_AND_FORWARD_RAM_SIZE];
+    RAMFrameQueueStorage _store_and_forward_ram;
+#endif
+    FrameQueueStorage * _store_and_forward_storage;
+    FrameQueue _store_and_forward_queue;
 
 #if defined(BOARD_HAS_SECRET_KEY)
     String _password;
@@ -178,8 +231,17 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
 
     static void onMessage(int length);
     void handleMessage(int length);
-    void sendMessage(Message * msg);
-    void sendPropertyContainerToCloud(String const topic, PropertyContainer & property_container, unsigned int & current_property_index);
+    size_t readMessage(uint8_t * data, size_t const length);
+    bool readProperties(CBORDecoder & decoder, size_t length);
+    void skipMessage(size_t length);
+    bool sendMessage(Message * msg);
+    void sendQueuedMessages();
+    void probePayloadSize(size_t const frame_size);
+    void adaptPayloadSize(bool const connected);
+    /* Returns false if a frame could not be written */
+    bool sendPropertyContainerToCloud(String const topic, PropertyContainer & property_container, unsigned int & current_property_index);
+    void storePropertyContainer(PropertyContainer & property_container);
+    void sendStoredProperties();
 
     void attachThing(String thingId);
     void detachThing();
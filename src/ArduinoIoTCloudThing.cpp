@@ -19,8 +19,6 @@
 
 #include "ArduinoIoTCloudThing.h"
 #include "interfaces/CloudProcess.h"
-#include "property/types/CloudWrapperInt.h"
-#include "property/types/CloudWrapperUnsignedInt.h"
 
 /******************************************************************************
  * CTOR/DTOR
@@ -32,8 +30,10 @@ _syncAttempt(0, 0),
 _propertyContainer(),
 _propertyContainerIndex(0),
 _utcOffset(0),
+_utcOffsetWrapper(_utcOffset),
 _utcOffsetProperty(nullptr),
 _utcOffsetExpireTime(0),
+_utcOffsetExpireTimeWrapper(_utcOffsetExpireTime),
 _utcOffsetExpireTimeProperty(nullptr) {
 }
 
@@ -42,17 +42,13 @@ _utcOffsetExpireTimeProperty(nullptr) {
  ******************************************************************************/
 
 void ArduinoCloudThing::begin() {
-  Property* property;
-
-  property = new CloudWrapperInt(_utcOffset);
   _utcOffsetProperty = &addPropertyToContainer(getPropertyContainer(),
-                                               *property,
+                                               _utcOffsetWrapper,
                                                "tz_offset",
                                                Permission::ReadWrite, -1);
   _utcOffsetProperty->writeOnDemand();
-  property = new CloudWrapperUnsignedInt(_utcOffsetExpireTime);
   _utcOffsetExpireTimeProperty = &addPropertyToContainer(getPropertyContainer(),
-                                                         *property,
+                                                         _utcOffsetExpireTimeWrapper,
                                                          "tz_dst_until",
                                                          Permission::ReadWrite, -1);
   _utcOffsetExpireTimeProperty->writeOnDemand();
@@ -166,8 +162,10 @@ ArduinoCloudThing::State ArduinoCloudThing::handleConnected() {
   }
 
   /* Check if any property needs encoding and send them to the cloud */
-  Message message = { PropertiesUpdateCmdId };
-  deliver(&message);
+  if (getPropertyContainer().hasDirtyProperties()) {
+    Message message = { PropertiesUpdateCmdId };
+    deliver(&message);
+  }
 
   if (getTime() > _utcOffsetExpireTime) {
     return State::RequestLastValues;
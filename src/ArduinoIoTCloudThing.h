@@ -19,6 +19,8 @@
 #include "interfaces/CloudProcess.h"
 #include "utility/time/TimedAttempt.h"
 #include "property/PropertyContainer.h"
+#include "property/types/CloudWrapperInt.h"
+#include "property/types/CloudWrapperUnsignedInt.h"
 
 /******************************************************************************
  * CLASS DECLARATION
@@ -56,8 +58,10 @@ private:
   PropertyContainer _propertyContainer;
   unsigned int _propertyContainerIndex;
   int _utcOffset;
+  CloudWrapperInt _utcOffsetWrapper;
   Property *_utcOffsetProperty;
   unsigned int _utcOffsetExpireTime;
+  CloudWrapperUnsignedInt _utcOffsetExpireTimeWrapper;
   Property *_utcOffsetExpireTimeProperty;
 
   State handleInit();
@@ -14,64 +14,110 @@
 
 #include "CBOR.h"
 
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+#define CBOR_FIELD(type, command, field) \
+  { CBORFieldType::type, offsetof(command, params.field), sizeof(static_cast<command *>(nullptr)->params.field), 0 }
+
+#define CBOR_FIELD_REF(command, field, length) \
+  { CBORFieldType::ByteStringRef, offsetof(command, params.field), sizeof(static_cast<command *>(nullptr)->params.field), offsetof(command, params.length) }
+
+#define CBOR_COMMAND(tag, id, direction, fields) \
+  { CBORCommandTag::tag, CommandId::id, CBORCommandDirection::direction, fields, sizeof(fields) / sizeof(fields[0]) }
+
+#define CBOR_COMMAND_NO_PARAMS(tag, id, direction) \
+  { CBORCommandTag::tag, CommandId::id, CBORCommandDirection::direction, nullptr, 0 }
+
+static constexpr CBORFieldDescriptor OtaBeginUpFields[] = {
+  CBOR_FIELD(ByteString, OtaBeginUp, sha),
+};
+
+static constexpr CBORFieldDescriptor ThingBeginCmdFields[] = {
+  CBOR_FIELD(TextString, ThingBeginCmd, thing_id),
+};
+
+static constexpr CBORFieldDescriptor DeviceBeginCmdFields[] = {
+  CBOR_FIELD(TextString, DeviceBeginCmd, lib_version),
+};
+
+static constexpr CBORFieldDescriptor OtaProgressCmdUpFields[] = {
+  CBOR_FIELD(ByteString,  OtaProgressCmdUp, id),
+  CBOR_FIELD(SimpleValue, OtaProgressCmdUp, state),
+  CBOR_FIELD(Int32,       OtaProgressCmdUp, state_data),
+  CBOR_FIELD(UInt64,      OtaProgressCmdUp, time),
+};
+
+static constexpr CBORFieldDescriptor OtaUpdateCmdDownFields[] = {
+  CBOR_FIELD(ByteString, OtaUpdateCmdDown, id),
+  CBOR_FIELD(TextString, OtaUpdateCmdDown, url),
+  CBOR_FIELD(ByteString, OtaUpdateCmdDown, initialSha256),
+  CBOR_FIELD(ByteString, OtaUpdateCmdDown, finalSha256),
+};
+
+static constexpr CBORFieldDescriptor ThingUpdateCmdFields[] = {
+  CBOR_FIELD(TextString, ThingUpdateCmd, thing_id),
+};
+
+static constexpr CBORFieldDescriptor ThingDetachCmdFields[] = {
+  CBOR_FIELD(TextString, ThingDetachCmd, thing_id),
+};
+
+static constexpr CBORFieldDescriptor LastValuesUpdateCmdFields[] = {
+  CBOR_FIELD_REF(LastValuesUpdateCmd, last_values, length),
+};
+
+static constexpr CBORFieldDescriptor TimezoneCommandDownFields[] = {
+  CBOR_FIELD(Int32,  TimezoneCommandDown, offset),
+  CBOR_FIELD(UInt32, TimezoneCommandDown, until),
+};
+
+static constexpr CBORCommandDescriptor CBORCommands[] = {
+  // Commands UP
+  CBOR_COMMAND          (CBOROtaBeginUp,          OtaBeginUpId,          Up,   OtaBeginUpFields),
+  CBOR_COMMAND          (CBORThingBeginCmd,       ThingBeginCmdId,       Up,   ThingBeginCmdFields),
+  CBOR_COMMAND_NO_PARAMS(CBORLastValuesBeginCmd,  LastValuesBeginCmdId,  Up),
+  CBOR_COMMAND          (CBORDeviceBeginCmd,      DeviceBeginCmdId,      Up,   DeviceBeginCmdFields),
+  CBOR_COMMAND          (CBOROtaProgressCmdUp,    OtaProgressCmdUpId,    Up,   OtaProgressCmdUpFields),
+  CBOR_COMMAND_NO_PARAMS(CBORTimezoneCommandUp,   TimezoneCommandUpId,   Up),
+
+  // Commands DOWN
+  CBOR_COMMAND          (CBOROtaUpdateCmdDown,    OtaUpdateCmdDownId,    Down, OtaUpdateCmdDownFields),
+  CBOR_COMMAND          (CBORThingUpdateCmd,      ThingUpdateCmdId,      Down, ThingUpdateCmdFields),
+  CBOR_COMMAND          (CBORThingDetachCmd,      ThingDetachCmdId,      Down, ThingDetachCmdFields),
+  CBOR_COMMAND          (CBORLastValuesUpdate,    LastValuesUpdateCmdId, Down, LastValuesUpdateCmdFields),
+  CBOR_COMMAND          (CBORTimezoneCommandDown, TimezoneCommandDownId, Down, TimezoneCommandDownFields),
+};
+
 /******************************************************************************
  * FUNCTION DEFINITION
  ******************************************************************************/
 
-CommandId toCommandId(CBORCommandTag tag) {
-  switch(tag) {
-  case CBORCommandTag::CBOROtaBeginUp:
-    return CommandId::OtaBeginUpId;
-  case CBORCommandTag::CBORThingBeginCmd:
-    return CommandId::ThingBeginCmdId;
-  case CBORCommandTag::CBORLastValuesBeginCmd:
-    return CommandId::LastValuesBeginCmdId;
-  case CBORCommandTag::CBORDeviceBeginCmd:
-    return CommandId::DeviceBeginCmdId;
-  case CBORCommandTag::CBOROtaProgressCmdUp:
-    return CommandId::OtaProgressCmdUpId;
-  case CBORCommandTag::CBORTimezoneCommandUp:
-    return CommandId::TimezoneCommandUpId;
-  case CBORCommandTag::CBOROtaUpdateCmdDown:
-    return CommandId::OtaUpdateCmdDownId;
-  case CBORCommandTag::CBORThingUpdateCmd:
-    return CommandId::ThingUpdateCmdId;
-  case CBORCommandTag::CBORThingDetachCmd:
-    return CommandId::ThingDetachCmdId;
-  case CBORCommandTag::CBORLastValuesUpdate:
-    return CommandId::LastValuesUpdateCmdId;
-  case CBORCommandTag::CBORTimezoneCommandDown:
-    return CommandId::TimezoneCommandDownId;
-  default:
-    return CommandId::UnknownCmdId;
+CBORCommandDescriptor const * findCBORCommand(CommandId id) {
+  for (CBORCommandDescriptor const & command : CBORCommands) {
+    if (command.id == id) {
+      return &command;
+    }
   }
+  return nullptr;
 }
 
-CBORCommandTag toCBORCommandTag(CommandId id) {
-  switch(id) {
-  case CommandId::OtaBeginUpId:
-    return CBORCommandTag::CBOROtaBeginUp;
-  case CommandId::ThingBeginCmdId:
-    return CBORCommandTag::CBORThingBeginCmd;
-  case CommandId::LastValuesBeginCmdId:
-    return CBORCommandTag::CBORLastValuesBeginCmd;
-  case CommandId::DeviceBeginCmdId:
-    return CBORCommandTag::CBORDeviceBeginCmd;
-  case CommandId::OtaProgressCmdUpId:
-    return CBORCommandTag::CBOROtaProgressCmdUp;
-  case CommandId::TimezoneCommandUpId:
-    return CBORCommandTag::CBORTimezoneCommandUp;
-  case CommandId::OtaUpdateCmdDownId:
-    return CBORCommandTag::CBOROtaUpdateCmdDown;
-  case CommandId::ThingUpdateCmdId:
-    return CBORCommandTag::CBORThingUpdateCmd;
-  case CommandId::ThingDetachCmdId:
-    return CBORCommandTag::CBORThingDetachCmd;
-  case CommandId::LastValuesUpdateCmdId:
-    return CBORCommandTag::CBORLastValuesUpdate;
-  case CommandId::TimezoneCommandDownId:
-    return CBORCommandTag::CBORTimezoneCommandDown;
-  default:
-    return CBORCommandTag::CBORUnknownCmdTag;
+CBORCommandDescriptor const * findCBORCommand(CBORCommandTag tag) {
+  for (CBORCommandDescriptor const & command : CBORCommands) {
+    if (command.tag == tag) {
+      return &command;
+    }
   }
+  return nullptr;
+}
+
+CommandId toCommandId(CBORCommandTag tag) {
+  CBORCommandDescriptor const * command = findCBORCommand(tag);
+  return command ? command->id : CommandId::UnknownCmdId;
+}
+
+CBORCommandTag toCBORCommandTag(CommandId id) {
+  CBORCommandDescriptor const * command = findCBORCommand(id);
+  return command ? command->tag : CBORCommandTag::CBORUnknownCmdTag;
 }
@@ -15,6 +15,8 @@
  ******************************************************************************/
 #include <message/Commands.h>
 
+#include <stddef.h>
+
 /******************************************************************************
    TYPEDEF
  ******************************************************************************/
@@ -42,9 +44,51 @@ enum CBORCommandTag: uint64_t {
   CBORUnknownCmdTag       = CBORUnknownCmdTag32b
 };
 
+/* Type of a parameter of a command, encoded as an element of the CBOR array
+ * following the command tag.
+ */
+enum class CBORFieldType : uint8_t {
+  TextString,     /* char[size], null terminated */
+  ByteString,     /* uint8_t[size] */
+  ByteStringRef,  /* uint8_t const * referencing the decoded message, its length in a size_t */
+  SimpleValue,    /* uint8_t */
+  Int32,          /* int32_t */
+  UInt32,         /* uint32_t */
+  UInt64,         /* uint64_t */
+};
+
+enum class CBORCommandDirection : uint8_t {
+  Up,             /* Sent by the device, encoded only */
+  Down,           /* Sent by the cloud, decoded only */
+};
+
+/* Position of a parameter in the struct of the command */
+struct CBORFieldDescriptor {
+  CBORFieldType type;
+  uint16_t      offset;
+  uint16_t      size;
+  uint16_t      length_offset;  /* ByteStringRef only */
+};
+
+/* Layout of a command: its tag, its id and its parameters in array order. The
+ * message encoder and decoder are driven by these descriptors, a command is
+ * added by adding its descriptor to the table in CBOR.cpp.
+ */
+struct CBORCommandDescriptor {
+  CBORCommandTag              tag;
+  CommandId                   id;
+  CBORCommandDirection        direction;
+  CBORFieldDescriptor const * fields;
+  size_t                      field_count;
+};
+
 /******************************************************************************
  * FUNCTION DECLARATION
  ******************************************************************************/
 
+/* Return the descriptor of the command or nullptr if it has no CBOR encoding */
+CBORCommandDescriptor const * findCBORCommand(CommandId id);
+CBORCommandDescriptor const * findCBORCommand(CBORCommandTag tag);
+
 CommandId toCommandId(CBORCommandTag tag);
 CBORCommandTag toCBORCommandTag(CommandId id);
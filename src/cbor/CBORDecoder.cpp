@@ -27,27 +27,139 @@
 
 #include "CBORDecoder.h"
 
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+CBORDecoder::CBORDecoder(PropertyContainer & property_container, uint8_t * buffer, size_t const size, bool isSyncMessage)
+: _property_container{property_container}
+, _buffer{buffer}
+, _size{size}
+, _data{buffer}
+, _fill{0}
+, _pos{0}
+, _keep{0}
+, _state{State::ArrayHeader}
+, _indefinite_length{false}
+, _remaining_records{0}
+, _is_sync_message{isSyncMessage}
+, _current_property_base_time{0}
+, _current_property_time{0}
+{
+
+}
+
 /******************************************************************************
    PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
 
 void CBORDecoder::decode(PropertyContainer & property_container, uint8_t const * const payload, size_t const length, bool isSyncMessage)
 {
-  CborValue array_iter, map_iter,value_iter;
-  CborParser parser;
-  CborMapData map_data;
-  std::list<CborMapData> map_data_list; /* List of map data that will hold all the attributes of a property */
-  String current_property_name; /* Current property name during decoding: use to look for a new property in the senml value array */
-  unsigned long current_property_base_time{0}, current_property_time{0};
+  /* The whole payload is available, it is decoded where it is */
+  CBORDecoder decoder(property_container, nullptr, 0, isSyncMessage);
+  decoder._data = payload;
+  decoder._fill = length;
+  decoder.process();
+}
+
+uint8_t * CBORDecoder::reserve(size_t & room)
+{
+  if (isDecoding() && (_fill == _size)) {
+    compact();
+  }
+
+  room = isDecoding() ? (_size - _fill) : 0;
+  return _buffer + _fill;
+}
+
+bool CBORDecoder::commit(size_t const length)
+{
+  _fill += std::min(length, _size - _fill);
+  process();
+  return (_state != State::Error);
+}
+
+/******************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void CBORDecoder::process()
+{
+  while (isDecoding()) {
+    if (_state == State::ArrayHeader) {
+      if (!decodeArrayHeader()) {
+        return;
+      }
+    } else if (!_indefinite_length && (_remaining_records == 0)) {
+      updateCurrentProperty();
+      _state = State::Complete;
+    } else if (_pos == _fill) {
+      return;
+    } else if (_indefinite_length && (_data[_pos] == 0xFF)) {
+      /* Break byte closing the array */
+      _pos++;
+      updateCurrentProperty();
+      _state = State::Complete;
+    } else if (!decodeRecord()) {
+      return;
+    }
+  }
+}
+
+bool CBORDecoder::decodeArrayHeader()
+{
+  /* The array header is parsed by hand, tinycbor would require the whole array */
+  if (_pos == _fill) {
+    return false;
+  }
+
+  uint8_t const initial_byte = _data[_pos];
+  uint8_t const additional_info = initial_byte & 0x1F;
+
+  if (((initial_byte & 0xE0) != CborArrayType) || ((additional_info > 27) && (additional_info != 31))) {
+    _state = State::Error;
+    return false;
+  }
+
+  if (additional_info == 31) {
+    _indefinite_length = true;
+    _pos += 1;
+  } else {
+    size_t const header_size = headerSize(initial_byte);
+    if ((_fill - _pos) < header_size) {
+      return false;
+    }
 
-  if (cbor_parser_init(payload, length, 0, &parser, &array_iter) != CborNoError)
-    return;
+    _remaining_records = (additional_info < 24) ? additional_info : 0;
+    for (size_t i = 1; i < header_size; i++) {
+      _remaining_records = (_remaining_records << 8) | _data[_pos + i];
+    }
+    _pos += header_size;
+  }
 
-  if (array_iter.type != CborArrayType)
-    return;
+  _keep = _pos;
+  _state = State::Records;
+  return true;
+}
 
-  if (cbor_value_enter_container(&array_iter, &map_iter) != CborNoError)
-    return;
+bool CBORDecoder::decodeRecord()
+{
+  CborParser parser;
+  CborValue map_iter, value_iter, record_end;
+  size_t const record_start = _pos;
+
+  /* A record is decoded only once it has been received completely */
+  CborError err = cbor_parser_init(_data + _pos, _fill - _pos, 0, &parser, &map_iter);
+  record_end = map_iter;
+  if (err == CborNoError) {
+    err = cbor_value_advance(&record_end);
+  }
+  if (err == CborErrorUnexpectedEOF) {
+    return false;
+  } else if (err != CborNoError) {
+    _state = State::Error;
+    return false;
+  }
 
   MapParserState current_state = MapParserState::EnterMap,
                  next_state = MapParserState::Error;
@@ -58,26 +170,203 @@ void CBORDecoder::decode(PropertyContainer & property_container, uint8_t const *
       case MapParserState::EnterMap     : next_state = handle_EnterMap(&map_iter, &value_iter); break;
       case MapParserState::MapKey       : next_state = handle_MapKey(&value_iter); break;
       case MapParserState::UndefinedKey : next_state = handle_UndefinedKey(&value_iter); break;
-      case MapParserState::BaseVersion  : next_state = handle_BaseVersion(&value_iter, map_data); break;
-      case MapParserState::BaseName     : next_state = handle_BaseName(&value_iter, map_data); break;
-      case MapParserState::BaseTime     : next_state = handle_BaseTime(&value_iter, map_data); break;
-      case MapParserState::Time         : next_state = handle_Time(&value_iter, map_data); break;
-      case MapParserState::Name         : next_state = handle_Name(&value_iter, map_data, property_container); break;
-      case MapParserState::Value        : next_state = handle_Value(&value_iter, map_data); break;
-      case MapParserState::StringValue  : next_state = handle_StringValue(&value_iter, map_data); break;
-      case MapParserState::BooleanValue : next_state = handle_BooleanValue(&value_iter, map_data); break;
-      case MapParserState::LeaveMap     : next_state = handle_LeaveMap(&map_iter, &value_iter, map_data, property_container, current_property_name, current_property_base_time, current_property_time, isSyncMessage, map_data_list); break;
+      case MapParserState::BaseVersion  : next_state = handle_BaseVersion(&value_iter, _map_data); break;
+      case MapParserState::BaseName     : next_state = handle_BaseName(&value_iter, _map_data); break;
+      case MapParserState::BaseTime     : next_state = handle_BaseTime(&value_iter, _map_data); break;
+      case MapParserState::Time         : next_state = handle_Time(&value_iter, _map_data); break;
+      case MapParserState::Name         : next_state = handle_Name(&value_iter, _map_data, _property_container); break;
+      case MapParserState::Value        : next_state = handle_Value(&value_iter, _map_data); break;
+      case MapParserState::StringValue  : next_state = handle_StringValue(&value_iter, _map_data); break;
+      case MapParserState::BooleanValue : next_state = handle_BooleanValue(&value_iter, _map_data); break;
+      case MapParserState::LeaveMap     : next_state = handle_LeaveMap(&map_iter, &value_iter); break;
       case MapParserState::Complete     : /* Nothing to do */ break;
-      case MapParserState::Error        : return; break;
+      case MapParserState::Error        : _state = State::Error; return false; break;
     }
 
     current_state = next_state;
   }
+
+  _pos += static_cast<size_t>(cbor_value_get_next_byte(&record_end) - (_data + record_start));
+  if (!_indefinite_length) {
+    _remaining_records--;
+  }
+  if (!appendRecord(record_start)) {
+    _state = State::Error;
+    return false;
+  }
+  return true;
 }
 
-/******************************************************************************
-   PRIVATE MEMBER FUNCTIONS
- ******************************************************************************/
+bool CBORDecoder::appendRecord(size_t const record_start)
+{
+  if (_map_data.name.isSet()) {
+    CborStringView propertyName = _map_data.name.get();
+    int colonPos = propertyName.indexOf(':');
+    if (colonPos != -1) {
+      propertyName = propertyName.prefix(colonPos);
+    }
+
+    if (_current_property_name.length() > 0 && !propertyName.equals(_current_property_name)) {
+      updateCurrentProperty();
+    }
+    /* Compute the cloud change event baseTime and Time */
+    if (_map_data.base_time.isSet()) {
+      _current_property_base_time = (unsigned long)(_map_data.base_time.get());
+    }
+    if (_map_data.time.isSet() && (_map_data.time.get() > _current_property_time)) {
+      _current_property_time = (unsigned long)_map_data.time.get();
+    }
+    if (_map_data_list.empty()) {
+      _keep = record_start;
+    }
+    /* A property is applied once, with all its records: more attributes than the list holds reject the message */
+    if (!_map_data_list.push_back(_map_data)) {
+      return false;
+    }
+    _current_property_name = propertyName;
+  }
+
+  if (_map_data_list.empty()) {
+    _keep = _pos;
+  }
+  return true;
+}
+
+void CBORDecoder::updateCurrentProperty()
+{
+  /* Update the property containers depending on the parsed data */
+  updateProperty(_property_container, _current_property_name, _current_property_base_time + _current_property_time, _is_sync_message, &_map_data_list);
+  /* Reset current property data */
+  _map_data_list.clear();
+  _current_property_name = CborStringView();
+  _current_property_base_time = 0;
+  _current_property_time = 0;
+  _keep = _pos;
+}
+
+void CBORDecoder::compact()
+{
+  if (_keep == 0) {
+    /* A property is never applied in parts: it is applied to make room only
+     * once the record being received is known to start another property
+     */
+    if (_map_data_list.empty() || !isNextRecordOfOtherProperty()) {
+      _state = State::Error;
+      return;
+    }
+    updateCurrentProperty();
+  }
+
+  /* The name of a record without one, which is the name of the previous
+   * record, lies in the records kept: those of the property being decoded
+   */
+  size_t const shift = _keep;
+  relocate(_map_data, shift);
+  for (CborMapData & map_data : _map_data_list) {
+    relocate(map_data, shift);
+  }
+  relocate(_current_property_name, shift);
+
+  memmove(_buffer, _buffer + shift, _fill - shift);
+  _fill -= shift;
+  _pos  -= shift;
+  _keep  = 0;
+}
+
+bool CBORDecoder::isNextRecordOfOtherProperty()
+{
+  /* Only the name of the record being received is looked for, the record is
+   * decoded once complete. Records open with their name.
+   */
+  CborParser parser;
+  CborValue map_iter, value_iter;
+  if ((cbor_parser_init(_data + _pos, _fill - _pos, 0, &parser, &map_iter) != CborNoError) ||
+      (handle_EnterMap(&map_iter, &value_iter) != MapParserState::MapKey)) {
+    return false;
+  }
+
+  while (!cbor_value_at_end(&value_iter)) {
+    int key = 0;
+    if (!cbor_value_is_integer(&value_iter) || (cbor_value_get_int(&value_iter, &key) != CborNoError) || (cbor_value_advance(&value_iter) != CborNoError)) {
+      return false;
+    }
+    if (key != static_cast<int>(CborIntegerMapKey::Name)) {
+      if (cbor_value_advance(&value_iter) != CborNoError) {
+        return false;
+      }
+      continue;
+    }
+
+    CborStringView name;
+    if (cbor_value_is_integer(&value_iter)) {
+      int val = 0;
+      if (cbor_value_get_int(&value_iter, &val) != CborNoError) {
+        return false;
+      }
+      Property * property = getProperty(_property_container, LightPayloadIdentifier::property(val));
+      if (property) {
+        name = CborStringView(property->name(), strlen(property->name()));
+      }
+    } else {
+      /* The name must have been received entirely */
+      size_t length = 0;
+      if (!cbor_value_is_text_string(&value_iter) || !cbor_value_is_length_known(&value_iter) || (cbor_value_get_string_length(&value_iter, &length) != CborNoError)) {
+        return false;
+      }
+      uint8_t const * initial_byte = cbor_value_get_next_byte(&value_iter);
+      size_t const header_size = headerSize(initial_byte[0]);
+      if (static_cast<size_t>((_data + _fill) - initial_byte) < (header_size + length)) {
+        return false;
+      }
+      name = CborStringView(reinterpret_cast<char const *>(initial_byte + header_size), length);
+    }
+
+    int colonPos = name.indexOf(':');
+    if (colonPos != -1) {
+      name = name.prefix(colonPos);
+    }
+    return !name.equals(_current_property_name);
+  }
+
+  /* A record without a name belongs to the property being decoded */
+  return false;
+}
+
+bool CBORDecoder::relocate(CborStringView & text, size_t const shift)
+{
+  /* Names of properties referenced by light payloads live outside of the buffer */
+  uintptr_t const begin = reinterpret_cast<uintptr_t>(_buffer);
+  uintptr_t const data = reinterpret_cast<uintptr_t>(text.data());
+  if ((data < begin) || (data >= (begin + _fill))) {
+    return true;
+  }
+  if (data < (begin + shift)) {
+    return false;
+  }
+
+  text = CborStringView(text.data() - shift, text.length());
+  return true;
+}
+
+void CBORDecoder::relocate(MapEntry<CborStringView> & entry, size_t const shift)
+{
+  if (entry.isSet()) {
+    CborStringView text = entry.get();
+    if (relocate(text, shift)) {
+      entry.set(text);
+    } else {
+      entry.reset();
+    }
+  }
+}
+
+void CBORDecoder::relocate(CborMapData & map_data, size_t const shift)
+{
+  relocate(map_data.base_name, shift);
+  relocate(map_data.name, shift);
+  relocate(map_data.attribute_name, shift);
+  relocate(map_data.str_val, shift);
+}
 
 CBORDecoder::MapParserState CBORDecoder::handle_EnterMap(CborValue * map_iter, CborValue * value_iter) {
   MapParserState next_state = MapParserState::Error;
@@ -160,14 +449,10 @@ CBORDecoder::MapParserState CBORDecoder::handle_BaseVersion(CborValue * value_it
 CBORDecoder::MapParserState CBORDecoder::handle_BaseName(CborValue * value_iter, CborMapData & map_data) {
   MapParserState next_state = MapParserState::Error;
 
-  if (cbor_value_is_text_string(value_iter)) {
-    char * val      = 0;
-    size_t val_size = 0;
-    if (cbor_value_dup_text_string(value_iter, &val, &val_size, value_iter) == CborNoError) {
-      map_data.base_name.set(String(val));
-      free(val);
-      next_state = MapParserState::MapKey;
-    }
+  CborStringView val;
+  if (getTextString(value_iter, val)) {
+    map_data.base_name.set(val);
+    next_state = MapParserState::MapKey;
   }
 
   return next_state;
@@ -193,16 +478,13 @@ CBORDecoder::MapParserState CBORDecoder::handle_Name(CborValue * value_iter, Cbo
 
   if (cbor_value_is_text_string(value_iter)) {
     // if the value in the cbor message is a string, it corresponds to the name of the property to be updated (int the form [property_name]:[attribute_name])
-    char * val      = nullptr;
-    size_t val_size = 0;
-    if (cbor_value_dup_text_string(value_iter, &val, &val_size, value_iter) == CborNoError) {
-      String name = val;
-      free(val);
+    CborStringView name;
+    if (getTextString(value_iter, name)) {
       map_data.name.set(name);
-      int colonPos = name.indexOf(":");
-      String attribute_name = "";
+      int colonPos = name.indexOf(':');
+      CborStringView attribute_name;
       if (colonPos != -1) {
-        attribute_name = name.substring(colonPos + 1);
+        attribute_name = name.suffix(colonPos + 1);
       }
       map_data.attribute_name.set(attribute_name);
       next_state = MapParserState::MapKey;
@@ -212,12 +494,10 @@ CBORDecoder::MapParserState CBORDecoder::handle_Name(CborValue * value_iter, Cbo
     int val = 0;
     if (cbor_value_get_int(value_iter, &val) == CborNoError) {
       map_data.light_payload.set(true);
-      map_data.name_identifier.set(val & 255);
-      map_data.attribute_identifier.set(val >> 8);
-      map_data.light_payload.set(true);
-      String name = getPropertyNameByIdentifier(property_container, val);
-      map_data.name.set(name);
-
+      map_data.attribute_identifier.set(LightPayloadIdentifier::attribute(val));
+      // the name references the one of the property, which outlives the message
+      Property * property = getProperty(property_container, LightPayloadIdentifier::property(val));
+      map_data.name.set(property ? CborStringView(property->name(), strlen(property->name())) : CborStringView());
 
       if (cbor_value_advance(value_iter) == CborNoError) {
         next_state = MapParserState::MapKey;
@@ -225,8 +505,6 @@ CBORDecoder::MapParserState CBORDecoder::handle_Name(CborValue * value_iter, Cbo
     }
   }
 
-
-
   return next_state;
 }
 
@@ -248,14 +526,10 @@ CBORDecoder::MapParserState CBORDecoder::handle_Value(CborValue * value_iter, Cb
 CBORDecoder::MapParserState CBORDecoder::handle_StringValue(CborValue * value_iter, CborMapData & map_data) {
   MapParserState next_state = MapParserState::Error;
 
-  if (cbor_value_is_text_string(value_iter)) {
-    char * val      = 0;
-    size_t val_size = 0;
-    if (cbor_value_dup_text_string(value_iter, &val, &val_size, value_iter) == CborNoError) {
-      map_data.str_val.set(String(val));
-      free(val);
-      next_state = MapParserState::MapKey;
-    }
+  CborStringView val;
+  if (getTextString(value_iter, val)) {
+    map_data.str_val.set(val);
+    next_state = MapParserState::MapKey;
   }
 
   return next_state;
@@ -291,52 +565,43 @@ CBORDecoder::MapParserState CBORDecoder::handle_Time(CborValue * value_iter, Cbo
   return next_state;
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_LeaveMap(CborValue * map_iter, CborValue * value_iter, CborMapData & map_data, PropertyContainer & property_container, String & current_property_name, unsigned long & current_property_base_time, unsigned long & current_property_time, bool const is_sync_message, std::list<CborMapData> & map_data_list) {
+CBORDecoder::MapParserState CBORDecoder::handle_LeaveMap(CborValue * map_iter, CborValue * value_iter) {
   MapParserState next_state = MapParserState::Error;
-  if (map_data.name.isSet()) {
-    String propertyName;
-    int colonPos = map_data.name.get().indexOf(":");
-    if (colonPos != -1) {
-      propertyName = map_data.name.get().substring(0, colonPos);
-    } else {
-      propertyName = map_data.name.get();
-    }
 
-    if (current_property_name != "" && propertyName != current_property_name) {
-      /* Update the property containers depending on the parsed data */
-      updateProperty(property_container, current_property_name, current_property_base_time + current_property_time, is_sync_message, &map_data_list);
-      /* Reset current property data */
-      map_data_list.clear();
-      current_property_base_time = 0;
-      current_property_time = 0;
-    }
-    /* Compute the cloud change event baseTime and Time */
-    if (map_data.base_time.isSet()) {
-      current_property_base_time = (unsigned long)(map_data.base_time.get());
-    }
-    if (map_data.time.isSet() && (map_data.time.get() > current_property_time)) {
-      current_property_time = (unsigned long)map_data.time.get();
-    }
-    map_data_list.push_back(map_data);
-    current_property_name = propertyName;
-  }
-
-  /* Transition into the next map if available, otherwise finish */
   if (cbor_value_leave_container(map_iter, value_iter) == CborNoError) {
-    if (!cbor_value_at_end(map_iter)) {
-      next_state = MapParserState::EnterMap;
-    } else {
-      /* Update the property containers depending on the parsed data */
-      updateProperty(property_container, current_property_name, current_property_base_time + current_property_time, is_sync_message, &map_data_list);
-      /* Reset last property data */
-      map_data_list.clear();
-      next_state = MapParserState::Complete;
-    }
+    next_state = MapParserState::Complete;
   }
 
   return next_state;
 }
 
+size_t CBORDecoder::headerSize(uint8_t const initial_byte) {
+  /* The size of the argument is given by the additional information of the initial byte */
+  uint8_t const additional_info = initial_byte & 0x1F;
+  return (additional_info < 24) ? 1 : (1 + (1 << (additional_info - 24)));
+}
+
+bool CBORDecoder::getTextString(CborValue * value_iter, CborStringView & text) {
+  /* A definite length text string is stored contiguously right after its header,
+   * whose size is given by the additional information of the initial byte.
+   * Chunked strings are not referenced in place and are rejected.
+   */
+  size_t length = 0;
+  if (!cbor_value_is_text_string(value_iter) || !cbor_value_is_length_known(value_iter))
+    return false;
+  if (cbor_value_get_string_length(value_iter, &length) != CborNoError)
+    return false;
+
+  uint8_t const * initial_byte = cbor_value_get_next_byte(value_iter);
+  size_t const header_size = headerSize(initial_byte[0]);
+
+  if (cbor_value_advance(value_iter) != CborNoError)
+    return false;
+
+  text = CborStringView(reinterpret_cast<char const *>(initial_byte + header_size), length);
+  return true;
+}
+
 bool CBORDecoder::ifNumericConvertToDouble(CborValue * value_iter, double * numeric_val) {
 
   if (cbor_value_is_integer(value_iter)) {
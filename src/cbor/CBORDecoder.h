@@ -26,7 +26,6 @@
 
 #undef max
 #undef min
-#include <list>
 
 #include "../property/PropertyContainer.h"
 
@@ -39,14 +38,42 @@ class CBORDecoder
 
 public:
 
-  /* decode a CBOR payload received from the cloud */
+  /* Decoder of a CBOR payload received in chunks into a buffer of size bytes.
+   * Every chunk is stored where reserve() points and passed to commit(), which
+   * decodes the records completed so far. Records are decoded in place and a
+   * property is applied once all its records are decoded, hence the buffer must
+   * hold all the records of a property plus the name of the following record:
+   * the bytes of the properties already applied are dropped to make room for
+   * the following ones.
+   */
+  CBORDecoder(PropertyContainer & property_container, uint8_t * buffer, size_t const size, bool isSyncMessage = false);
+
+  /* decode a CBOR payload received from the cloud. Names and string values are
+   * referenced in place in the payload and the records of a property are kept on
+   * the stack, hence decoding allocates nothing but the value of string properties.
+   */
   static void decode(PropertyContainer & property_container, uint8_t const * const payload, size_t const length, bool isSyncMessage = false);
 
+  /* Returns where the next chunk is to be stored, room is set to the number of
+   * bytes available, 0 if the payload is complete or cannot be decoded.
+   */
+  uint8_t * reserve(size_t & room);
+  /* Decodes the length bytes stored by the last chunk, returns false on error */
+  bool      commit(size_t const length);
+
+  inline bool isComplete() const { return _state == State::Complete; }
+
 
 private:
 
-  CBORDecoder() { }
-  CBORDecoder(CBORDecoder const &) { }
+  CBORDecoder(CBORDecoder const &);
+
+  enum class State {
+    ArrayHeader,
+    Records,
+    Complete,
+    Error
+  };
 
   enum class MapParserState {
     EnterMap,
@@ -65,6 +92,37 @@ private:
     Error
   };
 
+  PropertyContainer & _property_container;
+  uint8_t * _buffer;
+  size_t _size;
+  uint8_t const * _data;
+  size_t _fill;
+  size_t _pos;
+  /* Start of the bytes still referenced: the records of the property being decoded */
+  size_t _keep;
+  State _state;
+  bool _indefinite_length;
+  uint64_t _remaining_records;
+  bool _is_sync_message;
+  CborMapData _map_data;
+  CborMapDataList _map_data_list; /* List of map data that will hold all the attributes of a property */
+  CborStringView _current_property_name; /* Current property name during decoding: use to look for a new property in the senml value array */
+  unsigned long _current_property_base_time;
+  unsigned long _current_property_time;
+
+  inline bool isDecoding() const { return (_state == State::ArrayHeader) || (_state == State::Records); }
+
+  void process();
+  bool decodeArrayHeader();
+  bool decodeRecord();
+  bool appendRecord(size_t const record_start);
+  void updateCurrentProperty();
+  void compact();
+  bool isNextRecordOfOtherProperty();
+  bool relocate(CborStringView & text, size_t const shift);
+  void relocate(MapEntry<CborStringView> & entry, size_t const shift);
+  void relocate(CborMapData & map_data, size_t const shift);
+
   static MapParserState handle_EnterMap(CborValue * map_iter, CborValue * value_iter);
   static MapParserState handle_MapKey(CborValue * value_iter);
   static MapParserState handle_UndefinedKey(CborValue * value_iter);
@@ -76,8 +134,10 @@ private:
   static MapParserState handle_StringValue(CborValue * value_iter, CborMapData & map_data);
   static MapParserState handle_BooleanValue(CborValue * value_iter, CborMapData & map_data);
   static MapParserState handle_Time(CborValue * value_iter, CborMapData & map_data);
-  static MapParserState handle_LeaveMap(CborValue * map_iter, CborValue * value_iter, CborMapData & map_data, PropertyContainer & property_container, String & current_property_name, unsigned long & current_property_base_time, unsigned long & current_property_time, bool const is_sync_message, std::list<CborMapData> & map_data_list);
+  static MapParserState handle_LeaveMap(CborValue * map_iter, CborValue * value_iter);
 
+  static size_t headerSize(uint8_t const initial_byte);
+  static bool   getTextString(CborValue * value_iter, CborStringView & text);
   static bool   ifNumericConvertToDouble(CborValue * value_iter, double * numeric_val);
   static double convertCborHalfFloatToDouble(uint16_t const half_val);
 
@@ -21,10 +21,15 @@
 
 #include "CBOREncoder.h"
 
+#include <AIoTC_Config.h>
+
+#if defined(DEBUG_ERROR) || defined(DEBUG_WARNING) || defined(DEBUG_INFO) || defined(DEBUG_DEBUG) || defined(DEBUG_VERBOSE)
+#  include <Arduino_DebugUtils.h>
+#endif
+
 #undef max
 #undef min
 #include <algorithm>
-#include <iterator>
 
 #include "lib/tinycbor/cbor-lib.h"
 
@@ -32,24 +37,31 @@
  * PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
 
-CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload)
+CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload, bool senmlBaseCompression, bool compactFloats)
 {
   EncoderState current_state = EncoderState::InitPropertyEncoder,
                next_state = EncoderState::InitPropertyEncoder;
 
-  PropertyContainerEncoder propertyEncoder(property_container, current_property_index);
+  /* Idle update cycle: no property needs to be checked */
+  if (!property_container.hasDirtyProperties()) {
+    bytes_encoded = 0;
+    return CborNoError;
+  }
+
+  /* Never resume past the end of the container */
+  if (current_property_index >= property_container.size())
+    current_property_index = 0;
+
+  PropertyContainerEncoder propertyEncoder(property_container, current_property_index, senmlBaseCompression, compactFloats);
 
   while (current_state != EncoderState::SendMessage) {
 
     switch (current_state) {
       case EncoderState::InitPropertyEncoder      : next_state = handle_InitPropertyEncoder(propertyEncoder); break;
       case EncoderState::OpenCBORContainer        : next_state = handle_OpenCBORContainer(propertyEncoder, data, size); break;
-      case EncoderState::TryAppend                : next_state = handle_TryAppend(propertyEncoder, lightPayload); break;
-      case EncoderState::OutOfMemory              : next_state = handle_OutOfMemory(propertyEncoder); break;
+      case EncoderState::TryAppend                : next_state = handle_TryAppend(propertyEncoder, data, size, lightPayload); break;
       case EncoderState::SkipProperty             : next_state = handle_SkipProperty(propertyEncoder); break;
-      case EncoderState::TrimAppend               : next_state = handle_TrimAppend(propertyEncoder); break;
       case EncoderState::CloseCBORContainer       : next_state = handle_CloseCBORContainer(propertyEncoder); break;
-      case EncoderState::TrimClose                : next_state = handle_TrimClose(propertyEncoder); break;
       case EncoderState::FinishAppend             : next_state = handle_FinishAppend(propertyEncoder); break;
       case EncoderState::SendMessage              : /* Nothing to do */ break;
       case EncoderState::Error                    : return CborErrorInternalError; break;
@@ -74,8 +86,6 @@ CBOREncoder::EncoderState CBOREncoder::handle_InitPropertyEncoder(PropertyContai
 {
   propertyEncoder.encoded_property_count = 0;
   propertyEncoder.checked_property_count = 0;
-  propertyEncoder.encoded_property_limit = 0;
-  propertyEncoder.property_limit_active  = false;
   return EncoderState::OpenCBORContainer;
 }
 
@@ -83,58 +93,79 @@ CBOREncoder::EncoderState CBOREncoder::handle_OpenCBORContainer(PropertyContaine
 {
   propertyEncoder.encoded_property_count = 0;
   propertyEncoder.checked_property_count = 0;
+  propertyEncoder.senml_base.reset();
   cbor_encoder_init(&propertyEncoder.encoder, data, size, 0);
   cbor_encoder_create_array(&propertyEncoder.encoder, &propertyEncoder.arrayEncoder, CborIndefiniteLength);
   return EncoderState::TryAppend;
 }
 
-CBOREncoder::EncoderState CBOREncoder::handle_TryAppend(PropertyContainerEncoder & propertyEncoder, bool  & lightPayload)
+CBOREncoder::EncoderState CBOREncoder::handle_TryAppend(PropertyContainerEncoder & propertyEncoder, uint8_t * data, size_t const size, bool  & lightPayload)
 {
   /* Check if backing storage and cloud has diverged. Time interval may be elapsed or property may be changed
    * and if that's the case encode the property into the CBOR.
+   *
+   * Properties are packed in a single pass: the encoder state is saved before writing a property and restored
+   * if the property does not fit, together with the byte needed to close the array. The property state is only
+   * updated once its records are part of the message, a multi value property is therefore never split nor
+   * re-encoded and the message is never rebuilt from scratch.
+   *
+   * Properties of the high priority class are packed first, in round robin among them, the remaining room is
+   * filled in round robin among the other properties starting from current_property_index.
    */
   CborError error = CborNoError;
-  PropertyContainer::iterator iter = propertyEncoder.property_container.begin();
-  std::advance(iter, propertyEncoder.current_property_index);
+  std::vector<Property *> & high_priority_properties = propertyEncoder.property_container.highPriorityProperties();
+  size_t & high_priority_index = propertyEncoder.property_container.highPriorityIndex();
+
+  for (size_t i = 0; i < high_priority_properties.size(); i++)
+  {
+    size_t const index = (high_priority_index + i) % high_priority_properties.size();
+    error = tryAppend(propertyEncoder, high_priority_properties[index], data, size, lightPayload);
+    if ((CborErrorOutOfMemory == error) || (CborErrorSplitItems == error)) {
+      /* The message is full, the next one starts from this property */
+      if (propertyEncoder.encoded_property_count > 0) {
+        high_priority_index = index;
+        return EncoderState::CloseCBORContainer;
+      }
+      /* A property not fitting into an empty message would be tried first in
+       * every message and block the others: its value is dropped.
+       */
+      Property * p = high_priority_properties[index];
+      DEBUG_ERROR("CBOREncoder::%s high priority property %s larger than the message, value dropped", __FUNCTION__, p->name());
+      p->markAppended();
+      p->appendCompleted();
+    } else if (CborNoError != error) {
+      return EncoderState::Error;
+    }
+  }
+  error = CborNoError;
+
+  /* All high priority properties fit, the next message starts from the following one */
+  if (!high_priority_properties.empty())
+    high_priority_index = (high_priority_index + 1) % high_priority_properties.size();
+
+  PropertyContainer::iterator iter = propertyEncoder.property_container.begin() + propertyEncoder.current_property_index;
 
   for(; iter != propertyEncoder.property_container.end(); iter++)
   {
     Property * p = * iter;
 
-    if (p->shouldBeUpdated() && p->isReadableByCloud())
-    {
-      error = p->append(&propertyEncoder.arrayEncoder, lightPayload);
-      if(error == CborNoError)
-        propertyEncoder.encoded_property_count++;
-    }
+    if (!p->isHighPriority())
+      error = tryAppend(propertyEncoder, p, data, size, lightPayload);
+
     if(error == CborNoError)
       propertyEncoder.checked_property_count++;
-
-    bool const maximum_number_of_properties_reached = (propertyEncoder.encoded_property_count >= propertyEncoder.encoded_property_limit) && (propertyEncoder.property_limit_active == true);
-    bool const cbor_encoder_error = (error != CborNoError);
-
-    if (maximum_number_of_properties_reached || cbor_encoder_error)
+    else
       break;
   }
 
-  if (CborErrorOutOfMemory == error)
-    return EncoderState::OutOfMemory;
-  else if (CborNoError == error)
+  if (CborNoError == error)
     return EncoderState::CloseCBORContainer;
-  else if (CborErrorSplitItems == error)
-    return EncoderState::TrimAppend;
+  else if ((CborErrorOutOfMemory == error) || (CborErrorSplitItems == error))
+    return (propertyEncoder.encoded_property_count > 0) ? EncoderState::CloseCBORContainer : EncoderState::SkipProperty;
   else
     return EncoderState::Error;
 }
 
-CBOREncoder::EncoderState CBOREncoder::handle_OutOfMemory(PropertyContainerEncoder & propertyEncoder)
-{
-  if(propertyEncoder.encoded_property_count > 0)
-    return EncoderState::CloseCBORContainer;
-  else
-    return EncoderState::SkipProperty;
-}
-
 CBOREncoder::EncoderState CBOREncoder::handle_SkipProperty(PropertyContainerEncoder & propertyEncoder)
 {
   /* Better to skip this property otherwise we will stay blocked here. This happens only with a message property 
@@ -146,45 +177,20 @@ CBOREncoder::EncoderState CBOREncoder::handle_SkipProperty(PropertyContainerEnco
   return EncoderState::Error;
 }
 
-CBOREncoder::EncoderState CBOREncoder::handle_TrimAppend(PropertyContainerEncoder & propertyEncoder)
-{
-  /* Trim the number of properties to be included in the next message to avoid multivalue property split */
-  propertyEncoder.encoded_property_limit = propertyEncoder.encoded_property_count;
-  propertyEncoder.property_limit_active = true;
-  if(propertyEncoder.encoded_property_limit > 0)
-    return EncoderState::OpenCBORContainer;
-  else
-    return EncoderState::Error;
-}
-
 CBOREncoder::EncoderState CBOREncoder::handle_CloseCBORContainer(PropertyContainerEncoder & propertyEncoder)
 {
+  /* Room for the break byte has been kept while appending, closing the array cannot fail */
   CborError error = cbor_encoder_close_container(&propertyEncoder.encoder, &propertyEncoder.arrayEncoder);
   if (CborNoError != error)
-    return EncoderState::TrimClose;
+    return EncoderState::Error;
   else
     return EncoderState::FinishAppend;
 }
 
-CBOREncoder::EncoderState CBOREncoder::handle_TrimClose(PropertyContainerEncoder & propertyEncoder)
-{
-  /* Trim the number of properties to be included in the next message to avoid error closing container */
-  propertyEncoder.encoded_property_limit = propertyEncoder.encoded_property_count - 1;
-  propertyEncoder.property_limit_active = true;
-  if(propertyEncoder.encoded_property_limit > 0)
-    return EncoderState::OpenCBORContainer;
-  else
-    return EncoderState::Error;
-}
-
 CBOREncoder::EncoderState CBOREncoder::handle_FinishAppend(PropertyContainerEncoder & propertyEncoder)
 {
-  /* Restore property message limit to CBOR_ENCODER_NO_PROPERTIES_LIMIT */
-  propertyEncoder.property_limit_active = false;
-
   /* The append process has been successful, so we don't need to try to send this properties set. Cleanup _has_been_appended_but_not_sended flag */
-  PropertyContainer::iterator iter = propertyEncoder.property_container.begin();
-  std::advance(iter, propertyEncoder.current_property_index);
+  PropertyContainer::iterator iter = propertyEncoder.property_container.begin() + propertyEncoder.current_property_index;
   int num_appended_properties = 0;
 
   for(; iter != propertyEncoder.property_container.end(); iter++)
@@ -197,6 +203,10 @@ CBOREncoder::EncoderState CBOREncoder::handle_FinishAppend(PropertyContainerEnco
     num_appended_properties++;
   }
 
+  /* High priority properties are not counted by checked_property_count */
+  for (Property * p : propertyEncoder.property_container.highPriorityProperties())
+    p->appendCompleted();
+
   /* Advance property index for the next message */
   propertyEncoder.current_property_index += propertyEncoder.checked_property_count;
 
@@ -205,3 +215,25 @@ CBOREncoder::EncoderState CBOREncoder::handle_FinishAppend(PropertyContainerEnco
 
   return EncoderState::SendMessage;
 }
+
+CborError CBOREncoder::tryAppend(PropertyContainerEncoder & propertyEncoder, Property * p, uint8_t * data, size_t const size, bool const lightPayload)
+{
+  if (!p->isDirty() || !p->shouldBeUpdated() || !p->isReadableByCloud())
+    return CborNoError;
+
+  CborEncoder const array_encoder_checkpoint = propertyEncoder.arrayEncoder;
+  SenMLBase const senml_base_checkpoint = propertyEncoder.senml_base;
+
+  CborError error = p->encode(&propertyEncoder.arrayEncoder, lightPayload, propertyEncoder.senml_base_compression ? &propertyEncoder.senml_base : nullptr, propertyEncoder.compact_floats);
+  if ((error == CborNoError) && (cbor_encoder_get_buffer_size(&propertyEncoder.arrayEncoder, data) >= size))
+    error = CborErrorOutOfMemory;
+
+  if (error == CborNoError) {
+    p->markAppended();
+    propertyEncoder.encoded_property_count++;
+  } else {
+    propertyEncoder.arrayEncoder = array_encoder_checkpoint;
+    propertyEncoder.senml_base = senml_base_checkpoint;
+  }
+  return error;
+}
@@ -40,7 +40,9 @@ class CBOREncoder
 public:
     /* encode return > 0 if a property has changed and encodes the changed properties in CBOR format into the provided buffer */
     /* if lightPayload is true the integer identifier of the property will be encoded in the message instead of the property name in order to reduce the size of the message payload*/
-    static CborError encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload = false);
+    /* if senmlBaseCompression is true every property is encoded using the SenML base name and base time fields, attributes are encoded with relative names (ignored for light payloads) */
+    /* if compactFloats is true float values are encoded as integers or half precision floats when this loses no more precision than the minimum delta of the property */
+    static CborError encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload = false, bool senmlBaseCompression = false, bool compactFloats = false);
 
 private:
 
@@ -52,11 +54,8 @@ private:
     InitPropertyEncoder,
     OpenCBORContainer,
     TryAppend,
-    OutOfMemory,
     SkipProperty,
-    TrimAppend,
     CloseCBORContainer,
-    TrimClose,
     FinishAppend,
     SendMessage,
     Error
@@ -64,28 +63,28 @@ private:
 
   struct PropertyContainerEncoder
   {
-    PropertyContainerEncoder(PropertyContainer & _property_container, unsigned int & _current_property_index): property_container(_property_container), current_property_index(_current_property_index) { }
+    PropertyContainerEncoder(PropertyContainer & _property_container, unsigned int & _current_property_index, bool const _senml_base_compression, bool const _compact_floats): property_container(_property_container), current_property_index(_current_property_index), senml_base_compression(_senml_base_compression), compact_floats(_compact_floats) { }
     PropertyContainer & property_container;
     unsigned int & current_property_index;
+    bool const senml_base_compression;
+    bool const compact_floats;
+    SenMLBase senml_base;
     int encoded_property_count;
     int checked_property_count;
-    int encoded_property_limit;
-    bool property_limit_active;
     CborEncoder encoder;
     CborEncoder arrayEncoder;
   };
 
   static EncoderState handle_InitPropertyEncoder(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_OpenCBORContainer(PropertyContainerEncoder & propertyEncoder, uint8_t * data, size_t const size);
-  static EncoderState handle_TryAppend(PropertyContainerEncoder & propertyEncoder, bool  & lightPayload);
-  static EncoderState handle_OutOfMemory(PropertyContainerEncoder & propertyEncoder);
+  static EncoderState handle_TryAppend(PropertyContainerEncoder & propertyEncoder, uint8_t * data, size_t const size, bool  & lightPayload);
   static EncoderState handle_SkipProperty(PropertyContainerEncoder & propertyEncoder);
-  static EncoderState handle_TrimAppend(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_CloseCBORContainer(PropertyContainerEncoder & propertyEncoder);
-  static EncoderState handle_TrimClose(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_FinishAppend(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_AdvancePropertyContainer(PropertyContainerEncoder & propertyEncoder);
 
+  static CborError tryAppend(PropertyContainerEncoder & propertyEncoder, Property * p, uint8_t * data, size_t const size, bool const lightPayload);
+
 };
 
 #endif /* ARDUINO_CBOR_CBOR_ENCODER_H_ */
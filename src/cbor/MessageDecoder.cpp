@@ -64,6 +64,35 @@ Decoder::Status CBORMessageDecoder::decode(Message * message, uint8_t const * co
   return Decoder::Status::Complete;
 }
 
+bool CBORMessageDecoder::findLastValues(uint8_t const * const payload, size_t const available, size_t & offset, size_t & length)
+{
+  CborValue main_iter, array_iter;
+  CborTag tag;
+  CborParser parser;
+
+  /* tinycbor only requires the headers of the items to be available while entering them */
+  if (cbor_parser_init(payload, available, 0, &parser, &main_iter) != CborNoError)
+    return false;
+
+  if (main_iter.type != CborTagType || cbor_value_get_tag(&main_iter, &tag) != CborNoError)
+    return false;
+
+  if (toCommandId(CBORCommandTag(tag)) != CommandId::LastValuesUpdateCmdId)
+    return false;
+
+  if (cbor_value_advance(&main_iter) != CborNoError || handle_EnterArray(&main_iter, &array_iter) != ArrayParserState::ParseParam)
+    return false;
+
+  if (!cbor_value_is_byte_string(&array_iter) || !cbor_value_is_length_known(&array_iter))
+    return false;
+
+  if (cbor_value_get_string_length(&array_iter, &length) != CborNoError)
+    return false;
+
+  offset = byteStringContent(&array_iter) - payload;
+  return true;
+}
+
 /******************************************************************************
     PRIVATE MEMBER FUNCTIONS
  ******************************************************************************/
@@ -92,6 +121,14 @@ bool copyCBORByteToArray(CborValue * param, uint8_t * dest, size_t dest_size) {
   return false;
 }
 
+// The content of a definite length byte string immediately follows its header,
+// whose size is given by the additional information of the initial byte
+uint8_t const * CBORMessageDecoder::byteStringContent(CborValue * param) {
+  uint8_t const * initial_byte = cbor_value_get_next_byte(param);
+  uint8_t const additional_info = initial_byte[0] & 0x1F;
+  return initial_byte + ((additional_info < 24) ? 1 : (1 + (1 << (additional_info - 24))));
+}
+
 CBORMessageDecoder::ArrayParserState CBORMessageDecoder::handle_EnterArray(CborValue * main_iter, CborValue * array_iter) {
   ArrayParserState next_state = ArrayParserState::Error;
   if (cbor_value_get_type(main_iter) == CborArrayType) {
@@ -104,8 +141,8 @@ CBORMessageDecoder::ArrayParserState CBORMessageDecoder::handle_EnterArray(CborV
 }
 
 CBORMessageDecoder::ArrayParserState CBORMessageDecoder::handle_LeaveArray(CborValue * main_iter, CborValue * array_iter) {
-  // Advance to the next parameter (the last one in the array)
-  if (cbor_value_advance(array_iter) == CborNoError) {
+  // Advance to the next parameter (the last one in the array), if any
+  if (cbor_value_at_end(array_iter) || cbor_value_advance(array_iter) == CborNoError) {
     // Leave the array
     if (cbor_value_leave_container(main_iter, array_iter) == CborNoError) {
       return ArrayParserState::Complete;
@@ -115,130 +152,97 @@ CBORMessageDecoder::ArrayParserState CBORMessageDecoder::handle_LeaveArray(CborV
   return ArrayParserState::Error;
 }
 
-/******************************************************************************
-    MESSAGE DECODE FUNCTIONS
- ******************************************************************************/
-
-CBORMessageDecoder::ArrayParserState CBORMessageDecoder::decodeThingUpdateCmd(CborValue * param, Message * message) {
-  ThingUpdateCmd * thingCommand = (ThingUpdateCmd *) message;
-
-  // Message is composed of a single parameter, a string (thing_id)
-  if (!copyCBORStringToArray(param, thingCommand->params.thing_id, sizeof(thingCommand->params.thing_id))) {
-    return ArrayParserState::Error;
-  }
-
-  return ArrayParserState::LeaveArray;
-}
-
-CBORMessageDecoder::ArrayParserState CBORMessageDecoder::decodeThingDetachCmd(CborValue * param, Message * message) {
-  ThingDetachCmd * thingCommand = (ThingDetachCmd *) message;
+CBORMessageDecoder::ArrayParserState CBORMessageDecoder::handle_Param(CborValue * param, Message * message) {
+  CBORCommandDescriptor const * command = findCBORCommand(message->id);
 
-  // Message is composed of a single parameter, a string (thing_id)
-  if (!copyCBORStringToArray(param, thingCommand->params.thing_id, sizeof(thingCommand->params.thing_id))) {
-    return ArrayParserState::Error;
+  // Only the commands sent by the cloud are decoded
+  if (command == nullptr || command->direction != CBORCommandDirection::Down) {
+    return ArrayParserState::MessageNotSupported;
   }
 
-  return ArrayParserState::LeaveArray;
-}
-
-CBORMessageDecoder::ArrayParserState CBORMessageDecoder::decodeTimezoneCommandDown(CborValue * param, Message * message) {
-  TimezoneCommandDown * setTz = (TimezoneCommandDown *) message;
-
-  // Message is composed of 2 parameters, offset 32-bit signed integer and until 32-bit unsigned integer
-  // Get offset
-  if (cbor_value_is_integer(param)) {
-    int64_t val = 0;
-    if (cbor_value_get_int64(param, &val) == CborNoError) {
-      setTz->params.offset = static_cast<int32_t>(val);
+  uint8_t * params = reinterpret_cast<uint8_t *>(message);
+  for (size_t i = 0; i < command->field_count; i++) {
+    if (i > 0 && cbor_value_advance(param) != CborNoError) {
+      return ArrayParserState::Error;
     }
-  }
-
-  // Next
-  if (cbor_value_advance(param) != CborNoError) {
-    return ArrayParserState::Error;
-  }
-
-  // Get until
-  if (cbor_value_is_integer(param)) {
-    uint64_t val = 0;
-    if (cbor_value_get_uint64(param, &val) == CborNoError) {
-      setTz->params.until = static_cast<uint32_t>(val);
+    if (!decodeField(param, command->fields[i], params)) {
+      return ArrayParserState::Error;
     }
   }
 
   return ArrayParserState::LeaveArray;
 }
 
-CBORMessageDecoder::ArrayParserState CBORMessageDecoder::decodeLastValuesUpdateCmd(CborValue * param, Message * message) {
-  LastValuesUpdateCmd * setLv = (LastValuesUpdateCmd *) message;
+bool CBORMessageDecoder::decodeField(CborValue * param, CBORFieldDescriptor const & field, uint8_t * params) {
+  uint8_t * value = params + field.offset;
 
-  // Message is composed by a single parameter, a variable length byte array.
-  if (cbor_value_is_byte_string(param)) {
-    // Cortex M0 is not able to assign a value to pointed memory that is not 32bit aligned
-    // we use a support variable to cope with that
-    size_t s;
-    if (cbor_value_dup_byte_string(param, &setLv->params.last_values, &s, NULL) != CborNoError) {
-      return ArrayParserState::Error;
-    }
-
-    setLv->params.length = s;
-  }
+  switch (field.type)
+  {
+  case CBORFieldType::TextString:
+    return copyCBORStringToArray(param, reinterpret_cast<char *>(value), field.size);
 
-  return ArrayParserState::LeaveArray;
-}
+  case CBORFieldType::ByteString:
+    return copyCBORByteToArray(param, value, field.size);
 
-CBORMessageDecoder::ArrayParserState CBORMessageDecoder::decodeOtaUpdateCmdDown(CborValue * param, Message * message) {
-  CborError error = CborNoError;
-  OtaUpdateCmdDown * ota = (OtaUpdateCmdDown *) message;
+  case CBORFieldType::ByteStringRef:
+  {
+    // The byte string is referenced in place in the payload instead of being copied to the heap
+    size_t length = 0;
+    CborValue next = *param;
+    if (!cbor_value_is_byte_string(param) ||
+        !cbor_value_is_length_known(param) ||
+        cbor_value_get_string_length(param, &length) != CborNoError ||
+        cbor_value_advance(&next) != CborNoError) {
+      return false;
+    }
 
-  // Message is composed 4 parameters: id, url, initialSha, finalSha
-  if (!copyCBORByteToArray(param, ota->params.id, sizeof(ota->params.id))) {
-    return ArrayParserState::Error;
+    // Cortex M0 is not able to assign a value to pointed memory that is not 32bit aligned
+    // we copy the values to cope with that
+    uint8_t const * data = byteStringContent(param);
+    memcpy(value, &data, sizeof(data));
+    memcpy(params + field.length_offset, &length, sizeof(length));
+    return true;
   }
 
-  error = cbor_value_advance(param);
-
-  if ((error != CborNoError) || !copyCBORStringToArray(param, ota->params.url, sizeof(ota->params.url))) {
-    return ArrayParserState::Error;
+  case CBORFieldType::SimpleValue:
+  {
+    // Values of another type leave the parameter untouched
+    uint8_t val = 0;
+    if (cbor_value_get_simple_type(param, &val) == CborNoError) {
+      *value = val;
+    }
+    return true;
   }
 
-  error = cbor_value_advance(param);
-
-  if ((error != CborNoError) || !copyCBORByteToArray(param, ota->params.initialSha256, sizeof(ota->params.initialSha256))) {
-    return ArrayParserState::Error;
+  case CBORFieldType::Int32:
+  {
+    int64_t val = 0;
+    if (cbor_value_is_integer(param) && cbor_value_get_int64(param, &val) == CborNoError) {
+      int32_t const val32 = static_cast<int32_t>(val);
+      memcpy(value, &val32, sizeof(val32));
+    }
+    return true;
   }
 
-  error = cbor_value_advance(param);
-
-  if ((error != CborNoError) || !copyCBORByteToArray(param, ota->params.finalSha256, sizeof(ota->params.finalSha256))) {
-    return ArrayParserState::Error;
+  case CBORFieldType::UInt32:
+  {
+    uint64_t val = 0;
+    if (cbor_value_is_integer(param) && cbor_value_get_uint64(param, &val) == CborNoError) {
+      uint32_t const val32 = static_cast<uint32_t>(val);
+      memcpy(value, &val32, sizeof(val32));
+    }
+    return true;
   }
 
-  return ArrayParserState::LeaveArray;
-}
-
-CBORMessageDecoder::ArrayParserState CBORMessageDecoder::handle_Param(CborValue * param, Message * message) {
-
-  switch (message->id)
+  case CBORFieldType::UInt64:
   {
-  case CommandId::ThingUpdateCmdId:
-    return CBORMessageDecoder::decodeThingUpdateCmd(param, message);
-
-  case CommandId::ThingDetachCmdId:
-    return CBORMessageDecoder::decodeThingDetachCmd(param, message);
-
-  case CommandId::TimezoneCommandDownId:
-    return CBORMessageDecoder::decodeTimezoneCommandDown(param, message);
-
-  case CommandId::LastValuesUpdateCmdId:
-    return CBORMessageDecoder::decodeLastValuesUpdateCmd(param, message);
-
-  case CommandId::OtaUpdateCmdDownId:
-    return CBORMessageDecoder::decodeOtaUpdateCmdDown(param, message);
-
-  default:
-    return ArrayParserState::MessageNotSupported;
+    uint64_t val = 0;
+    if (cbor_value_is_integer(param) && cbor_value_get_uint64(param, &val) == CborNoError) {
+      memcpy(value, &val, sizeof(val));
+    }
+    return true;
+  }
   }
 
-  return ArrayParserState::LeaveArray;
+  return false;
 }
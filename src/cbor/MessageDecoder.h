@@ -38,6 +38,12 @@ public:
   /* decode a CBOR payload received from the cloud */
   Decoder::Status decode(Message * msg, uint8_t const * const payload, size_t& length);
 
+  /* Locates the SenML payload embedded in a LastValuesUpdate command, which starts
+   * offset bytes into the command and is length bytes long. Only the beginning of
+   * the command, up to the SenML payload, has to be available in payload.
+   */
+  bool findLastValues(uint8_t const * const payload, size_t const available, size_t & offset, size_t & length);
+
 private:
 
   enum class DecoderState {
@@ -60,15 +66,12 @@ private:
   ArrayParserState handle_Param(CborValue * param, Message * message);
   ArrayParserState handle_LeaveArray(CborValue * main_iter, CborValue * array_iter);
 
+  static uint8_t const * byteStringContent(CborValue * param);
+
   bool   ifNumericConvertToDouble(CborValue * value_iter, double * numeric_val);
   double convertCborHalfFloatToDouble(uint16_t const half_val);
 
-  // Message specific decoders
-  ArrayParserState decodeThingUpdateCmd(CborValue * param, Message * message);
-  ArrayParserState decodeThingDetachCmd(CborValue * param, Message * message);
-  ArrayParserState decodeTimezoneCommandDown(CborValue * param, Message * message);
-  ArrayParserState decodeLastValuesUpdateCmd(CborValue * param, Message * message);
-  ArrayParserState decodeOtaUpdateCmdDown(CborValue * param, Message * message);
+  bool decodeField(CborValue * param, CBORFieldDescriptor const & field, uint8_t * params);
 
 };
 
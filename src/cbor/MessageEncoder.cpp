@@ -33,15 +33,16 @@ Encoder::Status CBORMessageEncoder::encode(Message * message, uint8_t * data, si
 
   CborEncoder encoder;
   CborEncoder arrayEncoder;
+  CBORCommandDescriptor const * command = findCBORCommand(message->id);
 
   cbor_encoder_init(&encoder, data, len, 0);
 
   while (current_state != EncoderState::Complete) {
 
     switch (current_state) {
-      case EncoderState::EncodeTag            : next_state = handle_EncodeTag(&encoder, message); break;
-      case EncoderState::EncodeArray          : next_state = handle_EncodeArray(&encoder, &arrayEncoder, message); break;
-      case EncoderState::EncodeParam          : next_state = handle_EncodeParam(&arrayEncoder, message); break;
+      case EncoderState::EncodeTag            : next_state = handle_EncodeTag(&encoder, command); break;
+      case EncoderState::EncodeArray          : next_state = handle_EncodeArray(&encoder, &arrayEncoder, command); break;
+      case EncoderState::EncodeParam          : next_state = handle_EncodeParam(&arrayEncoder, command, message); break;
       case EncoderState::CloseArray           : next_state = handle_CloseArray(&encoder, &arrayEncoder); break;
       case EncoderState::Complete             : /* Nothing to do */ break;
       case EncoderState::MessageNotSupported  :
@@ -60,79 +61,42 @@ Encoder::Status CBORMessageEncoder::encode(Message * message, uint8_t * data, si
     PRIVATE MEMBER FUNCTIONS
  ******************************************************************************/
 
-CBORMessageEncoder::EncoderState CBORMessageEncoder::handle_EncodeTag(CborEncoder * encoder, Message * message)
+CBORMessageEncoder::EncoderState CBORMessageEncoder::handle_EncodeTag(CborEncoder * encoder, CBORCommandDescriptor const * command)
 {
-  CborTag commandTag = toCBORCommandTag(message->id);
-  if (commandTag == CBORCommandTag::CBORUnknownCmdTag16b ||
-      commandTag == CBORCommandTag::CBORUnknownCmdTag32b ||
-      commandTag == CBORCommandTag::CBORUnknownCmdTag64b ||
-      cbor_encode_tag(encoder, commandTag) != CborNoError) {
+  if (command == nullptr || cbor_encode_tag(encoder, command->tag) != CborNoError) {
     return EncoderState::Error;
   }
 
   return EncoderState::EncodeArray;
 }
 
-CBORMessageEncoder::EncoderState CBORMessageEncoder::handle_EncodeArray(CborEncoder * encoder, CborEncoder * array_encoder, Message * message)
+CBORMessageEncoder::EncoderState CBORMessageEncoder::handle_EncodeArray(CborEncoder * encoder, CborEncoder * array_encoder, CBORCommandDescriptor const * command)
 {
-  // Set array size based on the message id
-  size_t array_size = 0;
-  switch (message->id)
-  {
-  case CommandId::OtaBeginUpId:
-    array_size = 1;
-    break;
-  case CommandId::ThingBeginCmdId:
-    array_size = 1;
-    break;
-  case CommandId::DeviceBeginCmdId:
-    array_size = 1;
-    break;
-  case CommandId::LastValuesBeginCmdId:
-    break;
-  case CommandId::OtaProgressCmdUpId:
-    array_size = 4;
-    break;
-  case CommandId::TimezoneCommandUpId:
-    break;
-  default:
+  // Only the commands sent by the device are encoded
+  if (command->direction != CBORCommandDirection::Up) {
     return EncoderState::MessageNotSupported;
   }
 
   // Start an array with fixed width based on message type
-  if (cbor_encoder_create_array(encoder, array_encoder, array_size) != CborNoError){
+  if (cbor_encoder_create_array(encoder, array_encoder, command->field_count) != CborNoError){
     return EncoderState::Error;
   }
 
   return EncoderState::EncodeParam;
 }
 
-CBORMessageEncoder::EncoderState CBORMessageEncoder::handle_EncodeParam(CborEncoder * array_encoder, Message * message)
+CBORMessageEncoder::EncoderState CBORMessageEncoder::handle_EncodeParam(CborEncoder * array_encoder, CBORCommandDescriptor const * command, Message * message)
 {
-  CborError error = CborNoError;
-  switch (message->id)
-  {
-  case CommandId::OtaBeginUpId:
-    error = CBORMessageEncoder::encodeOtaBeginUp(array_encoder, message);
-    break;
-  case CommandId::ThingBeginCmdId:
-    error = CBORMessageEncoder::encodeThingBeginCmd(array_encoder, message);
-    break;
-  case CommandId::DeviceBeginCmdId:
-    error = CBORMessageEncoder::encodeDeviceBeginCmd(array_encoder, message);
-    break;
-  case CommandId::LastValuesBeginCmdId:
-    break;
-  case CommandId::OtaProgressCmdUpId:
-    error = CBORMessageEncoder::encodeOtaProgressCmdUp(array_encoder, message);
-    break;
-  case CommandId::TimezoneCommandUpId:
-    break;
-  default:
-    return EncoderState::MessageNotSupported;
+  uint8_t const * params = reinterpret_cast<uint8_t const *>(message);
+
+  for (size_t i = 0; i < command->field_count; i++) {
+    CBORFieldDescriptor const & field = command->fields[i];
+    if (encodeField(array_encoder, field, params + field.offset) != CborNoError) {
+      return EncoderState::Error;
+    }
   }
 
-  return (error != CborNoError) ? EncoderState::Error : EncoderState::CloseArray;
+  return EncoderState::CloseArray;
 }
 
 CBORMessageEncoder::EncoderState CBORMessageEncoder::handle_CloseArray(CborEncoder * encoder, CborEncoder * array_encoder)
@@ -142,34 +106,37 @@ CBORMessageEncoder::EncoderState CBORMessageEncoder::handle_CloseArray(CborEncod
   return (error != CborNoError) ? EncoderState::Error : EncoderState::Complete;
 }
 
-// Message specific encoders
-CborError CBORMessageEncoder::encodeOtaBeginUp(CborEncoder * array_encoder, Message * message)
-{
-  OtaBeginUp * otaBeginUp = (OtaBeginUp *) message;
-  CHECK_CBOR(cbor_encode_byte_string(array_encoder, otaBeginUp->params.sha, SHA256_SIZE));
-  return CborNoError;
-}
-
-CborError CBORMessageEncoder::encodeThingBeginCmd(CborEncoder * array_encoder, Message * message)
-{
-  ThingBeginCmd * thingBeginCmd = (ThingBeginCmd *) message;
-  CHECK_CBOR(cbor_encode_text_stringz(array_encoder, thingBeginCmd->params.thing_id));
-  return CborNoError;
-}
-
-CborError CBORMessageEncoder::encodeDeviceBeginCmd(CborEncoder * array_encoder, Message * message)
+CborError CBORMessageEncoder::encodeField(CborEncoder * array_encoder, CBORFieldDescriptor const & field, uint8_t const * value)
 {
-  DeviceBeginCmd * deviceBeginCmd = (DeviceBeginCmd *) message;
-  CHECK_CBOR(cbor_encode_text_stringz(array_encoder, deviceBeginCmd->params.lib_version));
-  return CborNoError;
-}
-
-CborError CBORMessageEncoder::encodeOtaProgressCmdUp(CborEncoder * array_encoder, Message * message)
-{
-  OtaProgressCmdUp * ota = (OtaProgressCmdUp *)message;
-  CHECK_CBOR(cbor_encode_byte_string(array_encoder, ota->params.id, ID_SIZE));
-  CHECK_CBOR(cbor_encode_simple_value(array_encoder, ota->params.state));
-  CHECK_CBOR(cbor_encode_int(array_encoder, ota->params.state_data));
-  CHECK_CBOR(cbor_encode_uint(array_encoder, ota->params.time));
-  return CborNoError;
+  // Parameters are read through their offset in the struct of the command, integers are copied
+  // out to avoid accessing them through a pointer of another type
+  switch (field.type)
+  {
+  case CBORFieldType::TextString:
+    return cbor_encode_text_stringz(array_encoder, reinterpret_cast<char const *>(value));
+  case CBORFieldType::ByteString:
+    return cbor_encode_byte_string(array_encoder, value, field.size);
+  case CBORFieldType::SimpleValue:
+    return cbor_encode_simple_value(array_encoder, *value);
+  case CBORFieldType::Int32:
+  {
+    int32_t val;
+    memcpy(&val, value, sizeof(val));
+    return cbor_encode_int(array_encoder, val);
+  }
+  case CBORFieldType::UInt32:
+  {
+    uint32_t val;
+    memcpy(&val, value, sizeof(val));
+    return cbor_encode_uint(array_encoder, val);
+  }
+  case CBORFieldType::UInt64:
+  {
+    uint64_t val;
+    memcpy(&val, value, sizeof(val));
+    return cbor_encode_uint(array_encoder, val);
+  }
+  default:
+    return CborErrorUnknownType;
+  }
 }
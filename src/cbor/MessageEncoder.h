@@ -50,16 +50,12 @@ private:
     Error
   };
 
-  EncoderState handle_EncodeTag(CborEncoder * encoder, Message * message);
-  EncoderState handle_EncodeArray(CborEncoder * encoder, CborEncoder * array_encoder, Message * message);
-  EncoderState handle_EncodeParam(CborEncoder * array_encoder, Message * message);
+  EncoderState handle_EncodeTag(CborEncoder * encoder, CBORCommandDescriptor const * command);
+  EncoderState handle_EncodeArray(CborEncoder * encoder, CborEncoder * array_encoder, CBORCommandDescriptor const * command);
+  EncoderState handle_EncodeParam(CborEncoder * array_encoder, CBORCommandDescriptor const * command, Message * message);
   EncoderState handle_CloseArray(CborEncoder * encoder, CborEncoder * array_encoder);
 
-  // Message specific encoders
-  CborError encodeThingBeginCmd(CborEncoder * array_encoder, Message * message);
-  CborError encodeOtaBeginUp(CborEncoder * array_encoder, Message * message);
-  CborError encodeDeviceBeginCmd(CborEncoder * array_encoder, Message * message);
-  CborError encodeOtaProgressCmdUp(CborEncoder * array_encoder, Message * message);
+  CborError encodeField(CborEncoder * array_encoder, CBORFieldDescriptor const & field, uint8_t const * value);
 };
 
 #endif /* ARDUINO_CBOR_MESSAGE_ENCODER_H_ */
@@ -43,10 +43,20 @@ protected:
   /**
    * Used by a derived class to send a message to the underlying messageStream
    * @param msg: the message to send
+   * @return false if the stream is full and the message has been dropped
    */
-  void deliver(Message* msg) {
+  bool deliver(Message* msg) {
     assert(stream != nullptr);
-    stream->sendUpstream(msg);
+    return stream->sendUpstream(msg);
+  }
+
+  /**
+   * Used by a derived class to have the delivered messages sent right away,
+   * e.g. before the device is reset
+   */
+  void flush() {
+    assert(stream != nullptr);
+    stream->flush();
   }
 
 private:
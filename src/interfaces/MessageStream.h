@@ -26,15 +26,26 @@ using upstreamFunction = std::function<void(Message*)>;
 class MessageStream {
 public:
   MessageStream(upstreamFunction upstream): upstream(upstream) {}
+  virtual ~MessageStream() { }
 
   /**
    * Send message upstream
    * @param m: message to send
+   * @return false if the message could not be accepted
    */
-  virtual inline void sendUpstream(Message* m) {
+  virtual inline bool sendUpstream(Message* m) {
     upstream(m);
+    return true;
   }
 
+  /**
+   * Send the messages held back by the stream, if any, e.g. before a reset
+   */
+  virtual inline void flush() { }
+
+protected:
+  MessageStream(): upstream(nullptr) {}
+
 private:
   upstreamFunction upstream;
 };
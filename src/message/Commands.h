@@ -104,7 +104,8 @@ struct LastValuesBeginCmd {
 struct LastValuesUpdateCmd {
   Command c;
   struct {
-    uint8_t * last_values;
+    /* References the SenML payload in the decoded message */
+    uint8_t const * last_values;
     size_t length;
   } params;
 };
@@ -148,6 +149,16 @@ struct TimezoneCommandDown {
   } params;
 };
 
+union CommandUp {
+  struct Command                  c;
+  struct DeviceBeginCmd           deviceBeginCmd;
+  struct ThingBeginCmd            thingBeginCmd;
+  struct LastValuesBeginCmd       lastValuesBeginCmd;
+  struct OtaBeginUp               otaBeginUp;
+  struct OtaProgressCmdUp         otaProgressCmdUp;
+  struct TimezoneCommandUp        timezoneCommandUp;
+};
+
 union CommandDown {
   struct Command                  c;
   struct OtaUpdateCmdDown         otaUpdateCmdDown;
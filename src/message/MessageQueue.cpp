@@ -0,0 +1,145 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "MessageQueue.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+MessageQueue::MessageQueue(senderFunction sender)
+: _sender{sender}
+, _head{0}
+, _size{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool MessageQueue::sendUpstream(Message* m)
+{
+  /* The superseded message is removed, the following ones move forward */
+  for (size_t i = 0; i < _size; i++) {
+    size_t const pos = (_head + i) % CAPACITY;
+    if (supersedes(m, &_messages[pos].c)) {
+      for (size_t j = i + 1; j < _size; j++) {
+        _messages[(_head + j - 1) % CAPACITY] = _messages[(_head + j) % CAPACITY];
+      }
+      _size--;
+      break;
+    }
+  }
+
+  if (full()) {
+    return false;
+  }
+
+  memcpy(&_messages[(_head + _size) % CAPACITY], m, messageSize(m));
+  _size++;
+  return true;
+}
+
+void MessageQueue::flush()
+{
+  if (!_sender) {
+    return;
+  }
+
+  for (Message * msg = front(); msg != nullptr; msg = front()) {
+    if (!_sender(msg)) {
+      return;
+    }
+    pop();
+  }
+}
+
+Message * MessageQueue::front()
+{
+  return empty() ? nullptr : &_messages[_head].c;
+}
+
+void MessageQueue::pop()
+{
+  if (!empty()) {
+    _head = (_head + 1) % CAPACITY;
+    _size--;
+  }
+}
+
+void MessageQueue::clear()
+{
+  _head = 0;
+  _size = 0;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+size_t MessageQueue::messageSize(Message const * m)
+{
+  switch (m->id) {
+    case CommandId::DeviceBeginCmdId:     return sizeof(DeviceBeginCmd);
+    case CommandId::ThingBeginCmdId:      return sizeof(ThingBeginCmd);
+    case CommandId::LastValuesBeginCmdId: return sizeof(LastValuesBeginCmd);
+    case CommandId::OtaBeginUpId:         return sizeof(OtaBeginUp);
+    case CommandId::OtaProgressCmdUpId:   return sizeof(OtaProgressCmdUp);
+    case CommandId::TimezoneCommandUpId:  return sizeof(TimezoneCommandUp);
+    default:                              return sizeof(Message);
+  }
+}
+
+bool MessageQueue::supersedes(Message const * m, Message const * pending)
+{
+  if (m->id != pending->id) {
+    return false;
+  }
+
+  switch (m->id) {
+    /* Requests without parameters: a repeated one is a duplicate */
+    case CommandId::LastValuesBeginCmdId:
+    case CommandId::PropertiesUpdateCmdId:
+    case CommandId::TimezoneCommandUpId:
+      return true;
+
+    /* The same command with other parameters is a different request */
+    case CommandId::DeviceBeginCmdId:
+      return strncmp(reinterpret_cast<DeviceBeginCmd const *>(m)->params.lib_version,
+                     reinterpret_cast<DeviceBeginCmd const *>(pending)->params.lib_version, MAX_LIB_VERSION_SIZE) == 0;
+    case CommandId::ThingBeginCmdId:
+      return strncmp(reinterpret_cast<ThingBeginCmd const *>(m)->params.thing_id,
+                     reinterpret_cast<ThingBeginCmd const *>(pending)->params.thing_id, THING_ID_SIZE) == 0;
+    case CommandId::OtaBeginUpId:
+      return memcmp(reinterpret_cast<OtaBeginUp const *>(m)->params.sha,
+                    reinterpret_cast<OtaBeginUp const *>(pending)->params.sha, SHA256_SIZE) == 0;
+
+    /* Progress reports of different states are all sent, only the
+     * progress within a state, e.g. the bytes downloaded, is coalesced
+     */
+    case CommandId::OtaProgressCmdUpId: {
+      OtaProgressCmdUp const * progress = reinterpret_cast<OtaProgressCmdUp const *>(m);
+      OtaProgressCmdUp const * pending_progress = reinterpret_cast<OtaProgressCmdUp const *>(pending);
+      return (progress->params.state == pending_progress->params.state) &&
+             (memcmp(progress->params.id, pending_progress->params.id, ID_SIZE) == 0);
+    }
+
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,75 @@
+/*
+  This file is part of the ArduinoIoTCloud library.
+
+  Copyright (c) 2024 Arduino SA
+
+  This Source Code Form is subject to the terms of the Mozilla Public
+  License, v. 2.0. If a copy of the MPL was not distributed with this
+  file, You can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+
+#pragma once
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <message/Commands.h>
+#include <interfaces/MessageStream.h>
+#include <functional>
+
+using senderFunction = std::function<bool(Message*)>;
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Bounded queue between the cloud processes and the transport. Messages
+ * delivered by the processes are copied into the queue and sent later on, when
+ * the transport drains it, so that neither encoding nor writing happens within
+ * the state machine of a process. A message supersedes the pending message it
+ * duplicates, i.e. the same request with the same parameters, e.g. a repeated
+ * LastValuesBeginCmd, or an OTA progress report of the same state: the pending
+ * one is dropped and the new one is queued after the messages delivered in
+ * between, so that the order of delivery is kept.
+ */
+class MessageQueue : public MessageStream {
+public:
+  MessageQueue(senderFunction sender = nullptr);
+
+  /**
+   * Queue a copy of the message
+   * @param m: message to send
+   * @return false if the queue is full and the message has been dropped
+   */
+  virtual bool sendUpstream(Message* m) override;
+
+  /**
+   * Send the pending messages in order through the sender. A message which
+   * cannot be sent stays at the head of the queue, with the following ones
+   * waiting behind it.
+   */
+  virtual void flush() override;
+
+  /* Oldest pending message, nullptr if the queue is empty */
+  Message * front();
+  /* Remove the oldest pending message once it has been sent */
+  void      pop();
+  /* Drop all the pending messages */
+  void      clear();
+
+  inline bool   empty() const { return _size == 0; }
+  inline bool   full()  const { return _size == CAPACITY; }
+  inline size_t size()  const { return _size; }
+
+  static size_t const CAPACITY = 8;
+
+private:
+  senderFunction _sender;
+  CommandUp _messages[CAPACITY];
+  size_t _head;
+  size_t _size;
+
+  static size_t messageSize(Message const * m);
+  static bool   supersedes(Message const * m, Message const * pending);
+};
@@ -77,13 +77,20 @@ OTACloudProcessInterface::~OTACloudProcessInterface() {
 
 void OTACloudProcessInterface::handleMessage(Message* msg) {
 
-  if ((state >= OtaAvailable || state < 0) && previous_state != state) {
+  bool const state_changed = (previous_state != state);
+
+  if ((state >= OtaAvailable || state < 0) && state_changed) {
     reportStatus(static_cast<int32_t>(state<0? state : 0));
   }
 
   // this allows to do status report only when the state changes
   previous_state = state;
 
+  // the device may reset while flashing or rebooting, the status report queued on entering the state is sent before
+  if (state_changed && (state == FlashOTA || state == Reboot)) {
+    flush();
+  }
+
   switch(state) {
   case Resume:         updateState(resume(msg));    break;
   case OtaBegin:       updateState(otaBegin());     break;
@@ -16,10 +16,14 @@
 //
 
 #include "Property.h"
+#include "PropertyContainer.h"
 
 #undef max
 #undef min
 #include <algorithm>
+#include <math.h>
+#include <new>
+#include <string.h>
 
 /******************************************************************************
    CTOR/DTOR
@@ -28,26 +32,33 @@ Property::Property()
 : _name{""}
 , _min_delta_property{0.0f}
 , _min_time_between_updates_millis{DEFAULT_MIN_TIME_BETWEEN_UPDATES_MILLIS}
+, _last_updated_millis{0}
+, _update_interval_millis{0}
+, _timestamp{0}
+, _identifier{0}
 , _permission{Permission::Read}
 , _write_policy{WritePolicy::Auto}
-, _get_time_func{nullptr}
-, _update_callback_func{nullptr}
-, _on_sync_callback_func{nullptr}
 , _update_policy{UpdatePolicy::OnChange}
+, _attributeIdentifier{0}
 , _has_been_updated_once{false}
 , _has_been_modified_in_callback{false}
 , _has_been_appended_but_not_sended{false}
-, _last_updated_millis{0}
-, _update_interval_millis{0}
-, _last_local_change_timestamp{0}
-, _last_cloud_change_timestamp{0}
-, _identifier{0}
-, _attributeIdentifier{0}
+, _has_been_stored_but_not_sended{false}
 , _lightPayload{false}
 , _update_requested{false}
 , _encode_timestamp{false}
 , _echo_requested{false}
-, _timestamp{0}
+, _compact_floats{false}
+, _encode_change_timestamp{false}
+, _high_priority{false}
+, _get_time_func{nullptr}
+, _update_callback_func{nullptr}
+, _on_sync_callback_func{nullptr}
+, _last_local_change_timestamp{0}
+, _last_cloud_change_timestamp{0}
+, _map_data_list{nullptr}
+, _senml_base{nullptr}
+, _link{}
 {
 
 }
@@ -63,10 +74,12 @@ namespace PropertyActions
 /******************************************************************************
    PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
-void Property::init(String const name, Permission const permission, GetTimeCallbackFunc func) {
+void Property::init(char const * name, Permission const permission, GetTimeCallbackFunc func) {
   _name = name;
   _permission = permission;
   _get_time_func = func;
+  /* A newly registered property has to be sent at least once */
+  markDirty();
 }
 
 Property & Property::onUpdate(UpdateCallbackFunc func) {
@@ -83,17 +96,20 @@ Property & Property::publishOnChange(float const min_delta_property, unsigned lo
   _update_policy = UpdatePolicy::OnChange;
   _min_delta_property = min_delta_property;
   _min_time_between_updates_millis = min_time_between_updates_millis;
+  markDirty();
   return (*this);
 }
 
 Property & Property::publishEvery(unsigned long const seconds) {
   _update_policy = UpdatePolicy::TimeInterval;
   _update_interval_millis = (seconds * 1000);
+  markDirty();
   return (*this);
 }
 
 Property & Property::publishOnDemand() {
   _update_policy = UpdatePolicy::OnDemand;
+  markDirty();
   return (*this);
 }
 
@@ -115,6 +131,19 @@ Property & Property::writeOnDemand()
   return (*this);
 }
 
+Property & Property::priority(Priority const priority)
+{
+  bool const high_priority = (priority == Priority::High);
+  if (high_priority == _high_priority) {
+    return (*this);
+  }
+  _high_priority = high_priority;
+  if (_link.container) {
+    _link.container->updatePriority(this);
+  }
+  return (*this);
+}
+
 void Property::setTimestamp(unsigned long const timestamp)
 {
   _timestamp = timestamp;
@@ -138,10 +167,26 @@ bool Property::shouldBeUpdated() {
   }
 
   if (_update_policy == UpdatePolicy::OnChange) {
-    return (isDifferentFromCloud() && ((millis() - _last_updated_millis) >= (_min_time_between_updates_millis)));
+    if (!isDifferentFromCloud()) {
+      clearDirty();
+      return false;
+    }
+    if ((millis() - _last_updated_millis) >= (_min_time_between_updates_millis)) {
+      return true;
+    }
+    /* Check again once the minimum time between updates has elapsed */
+    scheduleUpdate(_last_updated_millis + _min_time_between_updates_millis);
+    return false;
   } else if (_update_policy == UpdatePolicy::TimeInterval) {
-    return ((millis() - _last_updated_millis) >= _update_interval_millis);
+    if ((millis() - _last_updated_millis) >= _update_interval_millis) {
+      return true;
+    }
+    scheduleUpdate(_last_updated_millis + _update_interval_millis);
+    return false;
   } else if (_update_policy == UpdatePolicy::OnDemand) {
+    if (!_update_requested) {
+      clearDirty();
+    }
     return _update_requested;
   } else {
     return false;
@@ -151,17 +196,27 @@ bool Property::shouldBeUpdated() {
 void Property::requestUpdate()
 {
   _update_requested = true;
+  markDirty();
 }
 
 void Property::provideEcho()
 {
   _echo_requested = true;
+  markDirty();
 }
 
 void Property::appendCompleted()
 {
-  if (_has_been_appended_but_not_sended) {
+  if (_has_been_stored_but_not_sended) {
+    /* The update policy already applies to the stored value, a newer value is still to be sent */
+    _has_been_stored_but_not_sended = false;
+  } else if (_has_been_appended_but_not_sended) {
     _has_been_appended_but_not_sended = false;
+    if (_update_policy == UpdatePolicy::TimeInterval) {
+      scheduleUpdate(_last_updated_millis + _update_interval_millis);
+    } else {
+      clearDirty();
+    }
   }
 }
 
@@ -171,6 +226,7 @@ void Property::execCallbackOnChange() {
   }
   if (isDifferentFromCloud()) {
     _has_been_modified_in_callback = true;
+    markDirty();
   }
 }
 
@@ -180,114 +236,136 @@ void Property::execCallbackOnSync() {
   }
 }
 
-CborError Property::append(CborEncoder *encoder, bool lightPayload) {
+CborError Property::append(CborEncoder *encoder, bool lightPayload, SenMLBase * senmlBase, bool compactFloats) {
+  CHECK_CBOR(encode(encoder, lightPayload, senmlBase, compactFloats));
+  markAppended();
+  return CborNoError;
+}
+
+CborError Property::encode(CborEncoder *encoder, bool lightPayload, SenMLBase * senmlBase, bool compactFloats, bool timestamped) {
   _lightPayload = lightPayload;
+  _compact_floats = compactFloats;
+  _encode_change_timestamp = timestamped;
   _attributeIdentifier = 0;
-  CHECK_CBOR(appendAttributesToCloud(encoder));
+  _senml_base = lightPayload ? nullptr : senmlBase;
+  CborError const encode_error = appendAttributesToCloud(encoder);
+  _senml_base = nullptr;
+  return encode_error;
+}
+
+void Property::markAppended() {
   fromLocalToCloud();
   _has_been_updated_once = true;
   _has_been_modified_in_callback = false;
   _update_requested = false;
   _echo_requested = false;
   _has_been_appended_but_not_sended = true;
+  _has_been_stored_but_not_sended = false;
   _last_updated_millis = millis();
-  return CborNoError;
 }
 
-CborError Property::appendAttribute(bool value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+void Property::markStored() {
+  /* Without a pending append shouldBeUpdated() applies the update policy to the
+   * stored value: the property is stored again once changed and due.
+   */
+  markAppended();
+  _has_been_appended_but_not_sended = false;
+  _has_been_stored_but_not_sended = true;
+}
+
+void Property::storeDropped() {
+  /* Unless appended since, the value is sent again as if its append had failed */
+  if (_has_been_stored_but_not_sended) {
+    _has_been_stored_but_not_sended = false;
+    _has_been_appended_but_not_sended = true;
+    markDirty();
+  }
+}
+
+CborError Property::appendAttribute(bool value, char const * attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, [this, value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::BooleanValue)));
-    CHECK_CBOR(cbor_encode_boolean(&mapEncoder, value));
-    return CborNoError;
+    return appendValue(mapEncoder, value);
   }, encoder);
 }
 
-CborError Property::appendAttribute(int value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendAttribute(int value, char const * attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, [this, value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, value));
-    return CborNoError;
+    return appendValue(mapEncoder, value);
   }, encoder);
 }
 
-CborError Property::appendAttribute(unsigned int value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendAttribute(unsigned int value, char const * attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, [this, value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, value));
-    return CborNoError;
+    return appendValue(mapEncoder, value);
   }, encoder);
 }
 
-CborError Property::appendAttribute(float value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendAttribute(float value, char const * attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, [this, value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
-    CHECK_CBOR(cbor_encode_float(&mapEncoder, value));
-    return CborNoError;
+    return appendValue(mapEncoder, value);
   }, encoder);
 }
 
-CborError Property::appendAttribute(String value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendAttribute(String const & value, char const * attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, [this, &value](CborEncoder & mapEncoder)
   {
-    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::StringValue)));
-    CHECK_CBOR(cbor_encode_text_stringz(&mapEncoder, value.c_str()));
-    return CborNoError;
+    return appendValue(mapEncoder, value);
   }, encoder);
 }
 
-CborError Property::appendAttributeName(String attributeName, std::function<CborError (CborEncoder& mapEncoder)>appendValue, CborEncoder *encoder)
+CborError Property::appendAttributeName(char const * attributeName, std::function<CborError (CborEncoder& mapEncoder)>appendValue, CborEncoder *encoder)
 {
-  if (attributeName != "") {
+  if (attributeName[0] != '\0') {
     // when the attribute name string is not empty, the attribute identifier is incremented in order to be encoded in the message if the _lightPayload flag is set
     _attributeIdentifier++;
   }
+  if (_senml_base != nullptr) {
+    return appendCompressedAttributeName(attributeName, appendValue, encoder);
+  }
   CborEncoder mapEncoder;
-  unsigned int num_map_properties = _encode_timestamp ? 3 : 2;
+  bool const encode_time = _encode_timestamp || _encode_change_timestamp;
+  unsigned int num_map_properties = encode_time ? 3 : 2;
   CHECK_CBOR(cbor_encoder_create_map(encoder, &mapEncoder, num_map_properties));
   CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Name)));
 
   // if _lightPayload is true, the property and attribute identifiers will be encoded instead of the property name
   if (_lightPayload)
   {
-    // the most significant byte of the identifier to be encoded represent the property identifier
-    int completeIdentifier = _attributeIdentifier * 256;
-    // the least significant byte of the identifier to be encoded represent the attribute identifier
-    completeIdentifier += _identifier;
+    // the identifier to be encoded combines the property and the attribute identifier, see LightPayloadIdentifier
+    int completeIdentifier = LightPayloadIdentifier::compose(_identifier, _attributeIdentifier);
     CHECK_CBOR(cbor_encode_int(&mapEncoder, completeIdentifier));
   }
   else
   {
-    String completeName = _name;
-    if (attributeName != "") {
-      completeName += ":" + attributeName;
-    }
-    CHECK_CBOR(cbor_encode_text_stringz(&mapEncoder, completeName.c_str()));
+    CHECK_CBOR(appendName(&mapEncoder, (attributeName[0] != '\0') ? ":" : "", attributeName));
   }
   /* Encode the value */
   CHECK_CBOR(appendValue(mapEncoder));
 
   /* Encode the timestamp if that has been required. */
-  if(_encode_timestamp)
+  if(encode_time)
   {
     CHECK_CBOR(cbor_encode_int (&mapEncoder, static_cast<int>(CborIntegerMapKey::Time)));
-    CHECK_CBOR(cbor_encode_uint(&mapEncoder, _timestamp));
+    CHECK_CBOR(cbor_encode_uint(&mapEncoder, recordTime()));
   }
   /* Close the container */
   CHECK_CBOR(cbor_encoder_close_container(encoder, &mapEncoder));
   return CborNoError;
 }
 
-void Property::setAttributesFromCloud(std::list<CborMapData> * map_data_list) {
+void Property::setAttributesFromCloud(CborMapDataList * map_data_list) {
   _map_data_list = map_data_list;
   _attributeIdentifier = 0;
   setAttributesFromCloud();
+  /* The cloud value may now differ from the local one */
+  markDirty();
 }
 
-void Property::setAttribute(bool& value, String attributeName) {
+void Property::setAttribute(bool& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
     // Manage the case to have boolean values received as integers 0/1
     if (md.bool_val.isSet()) {
@@ -304,59 +382,41 @@ void Property::setAttribute(bool& value, String attributeName) {
   });
 }
 
-void Property::setAttribute(int& value, String attributeName) {
+void Property::setAttribute(int& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
     value = md.val.get();
   });
 }
 
-void Property::setAttribute(unsigned int& value, String attributeName) {
+void Property::setAttribute(unsigned int& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
     value = md.val.get();
   });
 }
 
-void Property::setAttribute(float& value, String attributeName) {
+void Property::setAttribute(float& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
     value = md.val.get();
   });
 }
 
-void Property::setAttribute(String& value, String attributeName) {
+void Property::setAttribute(String& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
-    value = md.str_val.get();
+    value = md.str_val.get().toString();
   });
 }
 
-void Property::setAttribute(String attributeName, std::function<void (CborMapData & md)>setValue)
+void Property::setAttribute(char const * attributeName, std::function<void (CborMapData & md)>setValue)
 {
-  if (attributeName != "") {
+  if (attributeName[0] != '\0') {
     _attributeIdentifier++;
   }
 
-  std::for_each(_map_data_list->begin(),
-                _map_data_list->end(),
-                [this, attributeName, setValue](CborMapData & map)
-                {
-                  if (map.light_payload.isSet() && map.light_payload.get())
-                  {
-                    // if a light payload is detected, the attribute identifier is retrieved from the cbor map and the corresponding attribute is updated
-                    int attid = map.attribute_identifier.get();
-                    if (attid == _attributeIdentifier) {
-                      setValue(map);
-                      return;
-                    }
-                  }
-                  else
-                  {
-                    // if a normal payload is detected, the name of the attribute to be updated is extracted directly from the cbor map
-                    String an = map.attribute_name.get();
-                    if (an == attributeName) {
-                      setValue(map);
-                      return;
-                    }
-                  }
-                });
+  // light payloads carry the attribute identifier, normal payloads the name of the attribute
+  CborMapData * map = _map_data_list->find(_attributeIdentifier, attributeName);
+  if (map != nullptr) {
+    setValue(*map);
+  }
 }
 
 void Property::updateLocalTimestamp() {
@@ -365,6 +425,7 @@ void Property::updateLocalTimestamp() {
       _last_local_change_timestamp = _get_time_func();
     }
   }
+  markDirty();
 }
 
 void Property::setLastCloudChangeTimestamp(unsigned long cloudChangeEventTime) {
@@ -387,6 +448,291 @@ void Property::setIdentifier(int identifier) {
   _identifier = identifier;
 }
 
+void Property::handleScheduledUpdate(unsigned long const due_millis) {
+  /* Ignore deadlines which have been superseded by a later schedule */
+  if (!_link.scheduled || (_link.due_millis != due_millis)) {
+    return;
+  }
+  _link.scheduled = false;
+  markDirty();
+}
+
+void Property::setContainer(PropertyContainer * container) {
+  /* The dirty state moves to the new container. A deadline scheduled in the
+   * previous container is lost: check it again.
+   */
+  bool const dirty = _link.dirty || _link.scheduled;
+  clearDirty();
+  _link.scheduled = false;
+  _link.container = container;
+  if (dirty) {
+    markDirty();
+  }
+}
+
+/******************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+/* Converts a finite float into a IEEE 754 half precision float, rounding the
+ * mantissa to nearest. Returns false if the value is out of the half range.
+ */
+static bool convertFloatToHalfFloat(float const value, uint16_t & half_val)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  uint16_t const sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  int const exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+  uint32_t mantissa = bits & 0x007FFFFF;
+
+  if ((bits & 0x7FFFFFFF) == 0) {
+    half_val = sign;
+    return true;
+  }
+  /* Below the smallest half subnormal, or infinite and NaN values */
+  if ((exponent < -10) || (exponent >= 31)) {
+    return false;
+  }
+
+  uint32_t half_magnitude;
+  if (exponent <= 0) {
+    /* Subnormal half: the implicit bit becomes part of the mantissa */
+    mantissa |= 0x00800000;
+    uint32_t const shift = static_cast<uint32_t>(14 - exponent);
+    half_magnitude = (mantissa + (1UL << (shift - 1))) >> shift;
+  } else {
+    /* A carry of the rounded mantissa correctly increments the exponent */
+    half_magnitude = ((static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1);
+  }
+
+  if (half_magnitude >= 0x7C00) {
+    return false;
+  }
+  half_val = static_cast<uint16_t>(sign | half_magnitude);
+  return true;
+}
+
+static float convertHalfFloatToFloat(uint16_t const half_val)
+{
+  int const exponent = (half_val >> 10) & 0x1F;
+  int const mantissa = half_val & 0x3FF;
+  float const magnitude = (exponent == 0) ? ldexpf(static_cast<float>(mantissa), -24)
+                                          : ldexpf(static_cast<float>(mantissa + 1024), exponent - 25);
+  return (half_val & 0x8000) ? -magnitude : magnitude;
+}
+
+CborError Property::appendValue(CborEncoder & mapEncoder, bool const value)
+{
+  CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::BooleanValue)));
+  CHECK_CBOR(cbor_encode_boolean(&mapEncoder, value));
+  return CborNoError;
+}
+
+CborError Property::appendValue(CborEncoder & mapEncoder, int const value)
+{
+  CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
+  CHECK_CBOR(cbor_encode_int(&mapEncoder, value));
+  return CborNoError;
+}
+
+CborError Property::appendValue(CborEncoder & mapEncoder, unsigned int const value)
+{
+  CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
+  CHECK_CBOR(cbor_encode_int(&mapEncoder, value));
+  return CborNoError;
+}
+
+CborError Property::appendValue(CborEncoder & mapEncoder, float const value)
+{
+  CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
+  CHECK_CBOR(appendFloatValue(mapEncoder, value));
+  return CborNoError;
+}
+
+CborError Property::appendValue(CborEncoder & mapEncoder, String const & value)
+{
+  CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::StringValue)));
+  CHECK_CBOR(cbor_encode_text_string(&mapEncoder, value.c_str(), value.length()));
+  return CborNoError;
+}
+
+CborError Property::appendFloatValue(CborEncoder & mapEncoder, float const value)
+{
+  if (_compact_floats) {
+    /* Integral values up to 16 bit take at most 3 bytes, as a half float does */
+    if ((value == truncf(value)) && (fabsf(value) <= 65535.0f)) {
+      return cbor_encode_int(&mapEncoder, static_cast<int64_t>(value));
+    }
+
+    uint16_t half_val = 0;
+    if (convertFloatToHalfFloat(value, half_val) &&
+        (fabsf(convertHalfFloatToFloat(half_val) - value) <= _min_delta_property)) {
+      return cbor_encode_half_float(&mapEncoder, &half_val);
+    }
+  }
+  return cbor_encode_float(&mapEncoder, value);
+}
+
+CborError Property::appendName(CborEncoder * mapEncoder, char const * separator, char const * attributeName)
+{
+  size_t const name_len = strlen(_name);
+  size_t const separator_len = strlen(separator);
+  size_t const attribute_len = strlen(attributeName);
+
+  if (separator_len == 0 && attribute_len == 0)
+    return cbor_encode_text_string(mapEncoder, _name, name_len);
+
+  /* Compose the "name:attribute" key on the stack, names longer than
+   * MAX_NAME_LENGTH are rejected at registration so the key always fits.
+   */
+  size_t const key_len = name_len + separator_len + attribute_len;
+  if (key_len > MAX_ATTRIBUTE_KEY_LENGTH)
+    return CborErrorDataTooLarge;
+
+  char key[MAX_ATTRIBUTE_KEY_LENGTH];
+  memcpy(key, _name, name_len);
+  memcpy(key + name_len, separator, separator_len);
+  memcpy(key + name_len + separator_len, attributeName, attribute_len);
+  return cbor_encode_text_string(mapEncoder, key, key_len);
+}
+
+CborError Property::appendCompressedAttributeName(char const * attributeName, std::function<CborError (CborEncoder& mapEncoder)>appendValue, CborEncoder *encoder)
+{
+  /* The first record of the property carries the base name ("name" or "name:")
+   * and, if it differs from the one in effect, the base time. The following
+   * records only carry the attribute name and inherit both.
+   */
+  bool const has_attribute = (attributeName[0] != '\0');
+  bool const is_first_record = (_attributeIdentifier <= 1);
+  unsigned long const base_time = recordTime();
+  bool const write_base_time = is_first_record && (base_time != _senml_base->base_time);
+
+  CborEncoder mapEncoder;
+  unsigned int num_map_properties = 1;
+  if (is_first_record) num_map_properties++;
+  if (has_attribute)   num_map_properties++;
+  if (write_base_time) num_map_properties++;
+  CHECK_CBOR(cbor_encoder_create_map(encoder, &mapEncoder, num_map_properties));
+
+  if (is_first_record) {
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::BaseName)));
+    CHECK_CBOR(appendName(&mapEncoder, has_attribute ? ":" : "", ""));
+  }
+  if (write_base_time) {
+    CHECK_CBOR(cbor_encode_int (&mapEncoder, static_cast<int>(CborIntegerMapKey::BaseTime)));
+    CHECK_CBOR(cbor_encode_uint(&mapEncoder, base_time));
+    _senml_base->base_time = base_time;
+  }
+  if (has_attribute) {
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Name)));
+    CHECK_CBOR(cbor_encode_text_stringz(&mapEncoder, attributeName));
+  }
+  CHECK_CBOR(appendValue(mapEncoder));
+
+  CHECK_CBOR(cbor_encoder_close_container(encoder, &mapEncoder));
+  return CborNoError;
+}
+
+CborError Property::appendSampleRecord(unsigned long const base_time, float const time_offset, bool const first_sample, std::function<CborError (CborEncoder& mapEncoder)>appendValue, CborEncoder *encoder)
+{
+  CborEncoder mapEncoder;
+
+  if (_senml_base != nullptr)
+  {
+    bool const write_base_time = first_sample && (base_time != _senml_base->base_time);
+    bool const write_time = (time_offset != 0.0f);
+
+    unsigned int num_map_properties = 1;
+    if (first_sample)    num_map_properties++;
+    if (write_base_time) num_map_properties++;
+    if (write_time)      num_map_properties++;
+    CHECK_CBOR(cbor_encoder_create_map(encoder, &mapEncoder, num_map_properties));
+
+    if (first_sample) {
+      CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::BaseName)));
+      CHECK_CBOR(appendName(&mapEncoder, "", ""));
+    }
+    if (write_base_time) {
+      CHECK_CBOR(cbor_encode_int (&mapEncoder, static_cast<int>(CborIntegerMapKey::BaseTime)));
+      CHECK_CBOR(cbor_encode_uint(&mapEncoder, base_time));
+      _senml_base->base_time = base_time;
+    }
+    CHECK_CBOR(appendValue(mapEncoder));
+    if (write_time) {
+      CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Time)));
+      if (time_offset == floorf(time_offset)) {
+        CHECK_CBOR(cbor_encode_uint(&mapEncoder, static_cast<uint64_t>(time_offset)));
+      } else {
+        CHECK_CBOR(cbor_encode_float(&mapEncoder, time_offset));
+      }
+    }
+  }
+  else
+  {
+    CHECK_CBOR(cbor_encoder_create_map(encoder, &mapEncoder, 3));
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Name)));
+    if (_lightPayload) {
+      CHECK_CBOR(cbor_encode_int(&mapEncoder, LightPayloadIdentifier::compose(_identifier, 0)));
+    } else {
+      CHECK_CBOR(appendName(&mapEncoder, "", ""));
+    }
+    CHECK_CBOR(appendValue(mapEncoder));
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Time)));
+    if (time_offset == floorf(time_offset)) {
+      CHECK_CBOR(cbor_encode_uint(&mapEncoder, base_time + static_cast<unsigned long>(time_offset)));
+    } else {
+      CHECK_CBOR(cbor_encode_double(&mapEncoder, static_cast<double>(base_time) + static_cast<double>(time_offset)));
+    }
+  }
+
+  CHECK_CBOR(cbor_encoder_close_container(encoder, &mapEncoder));
+  return CborNoError;
+}
+
+unsigned long Property::recordTime() const {
+  if (_encode_timestamp) {
+    return _timestamp;
+  }
+  if (_encode_change_timestamp) {
+    return _last_local_change_timestamp;
+  }
+  return 0;
+}
+
+void Property::markDirty() {
+  /* Properties which can not be read by the cloud are never sent */
+  if (_link.dirty || !isReadableByCloud()) {
+    return;
+  }
+  _link.dirty = true;
+  if (_link.container) {
+    _link.container->incrementDirtyCount();
+  }
+}
+
+void Property::clearDirty() {
+  if (!_link.dirty) {
+    return;
+  }
+  _link.dirty = false;
+  if (_link.container) {
+    _link.container->decrementDirtyCount();
+  }
+}
+
+void Property::scheduleUpdate(unsigned long const due_millis) {
+  clearDirty();
+  if (_link.scheduled && (_link.due_millis == due_millis)) {
+    return;
+  }
+  _link.scheduled = true;
+  _link.due_millis = due_millis;
+  if (_link.container) {
+    _link.container->schedule(this, due_millis);
+  }
+}
+
 /******************************************************************************
    SYNCHRONIZATION CALLBACKS
  ******************************************************************************/
@@ -408,3 +754,102 @@ void onForceCloudSync(Property & property) {
 void onForceDeviceSync(Property & /* property */) {
 
 }
+
+/******************************************************************************
+   PropertyName
+ ******************************************************************************/
+
+char const * PropertyName::persist() const
+{
+  if (_string == nullptr)
+    return _name;
+
+  /* Properties are never unregistered, the copy is never released */
+  size_t const len = _string->length();
+  char * copy = new (std::nothrow) char[len + 1];
+  if (copy != nullptr) {
+    memcpy(copy, _name, len);
+    copy[len] = '\0';
+  }
+  return copy;
+}
+
+/******************************************************************************
+   CborMapDataList
+ ******************************************************************************/
+
+void CborMapDataList::clear()
+{
+  _size = 0;
+  memset(_identifier_index, 0, sizeof(_identifier_index));
+  memset(_name_index, 0, sizeof(_name_index));
+}
+
+bool CborMapDataList::push_back(CborMapData const & map_data)
+{
+  /* A later record of the same attribute replaces the earlier one, hence the
+   * list holds at most one record per attribute
+   */
+  if (map_data.light_payload.isSet() && map_data.light_payload.get()) {
+    int const attribute_identifier = map_data.attribute_identifier.get();
+    bool const indexed = (attribute_identifier >= 0) && (static_cast<size_t>(attribute_identifier) < CAPACITY);
+    if (indexed && (_identifier_index[attribute_identifier] != 0)) {
+      _records[_identifier_index[attribute_identifier] - 1] = map_data;
+      return true;
+    }
+    if (_size >= CAPACITY) {
+      return false;
+    }
+    _records[_size++] = map_data;
+    if (indexed) {
+      _identifier_index[attribute_identifier] = static_cast<uint8_t>(_size);
+    }
+    return true;
+  }
+
+  CborStringView const name = map_data.attribute_name.get();
+  uint32_t const hash = hashName(name.data(), name.length());
+  size_t i = hash % NAME_INDEX_SIZE;
+  for (; _name_index[i] != 0; i = (i + 1) % NAME_INDEX_SIZE) {
+    if ((_name_hash[i] == hash) && _records[_name_index[i] - 1].attribute_name.get().equals(name)) {
+      _records[_name_index[i] - 1] = map_data;
+      return true;
+    }
+  }
+  if (_size >= CAPACITY) {
+    return false;
+  }
+  _records[_size++] = map_data;
+  _name_index[i] = static_cast<uint8_t>(_size);
+  _name_hash[i] = hash;
+  return true;
+}
+
+CborMapData * CborMapDataList::find(int const attribute_identifier, char const * attribute_name)
+{
+  if ((attribute_identifier >= 0) && (static_cast<size_t>(attribute_identifier) < CAPACITY) && (_identifier_index[attribute_identifier] != 0)) {
+    return &_records[_identifier_index[attribute_identifier] - 1];
+  }
+
+  size_t const length = strlen(attribute_name);
+  uint32_t const hash = hashName(attribute_name, length);
+  for (size_t i = hash % NAME_INDEX_SIZE; _name_index[i] != 0; i = (i + 1) % NAME_INDEX_SIZE) {
+    CborMapData & map = _records[_name_index[i] - 1];
+    if ((_name_hash[i] == hash) && map.attribute_name.get().equals(attribute_name, length)) {
+      return &map;
+    }
+  }
+  return nullptr;
+}
+
+/* 32 bit FNV-1a */
+uint32_t CborMapDataList::hashName(char const * name, size_t const length)
+{
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < length; i++)
+  {
+    hash ^= static_cast<uint8_t>(name[i]);
+    hash *= 16777619UL;
+  }
+  return hash;
+}
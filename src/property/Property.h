@@ -34,6 +34,7 @@
 
 # include <functional>
 #include <list>
+#include <string.h>
 
 #include "../cbor/lib/tinycbor/cbor-lib.h"
 
@@ -95,25 +96,171 @@ class MapEntry {
 
 };
 
+/* Text string referenced in place in a decoded message, or in the name of a
+ * property, without being copied. It is not null terminated and is valid only
+ * as long as the message is.
+ */
+class CborStringView {
+
+  public:
+    CborStringView() : _data{""}, _length{0} { }
+    CborStringView(char const * data, size_t const length) : _data{data}, _length{length} { }
+
+    inline char const * data()   const { return _data; }
+    inline size_t       length() const { return _length; }
+
+    inline bool equals(char const * str, size_t const length) const {
+      return (_length == length) && (memcmp(_data, str, length) == 0);
+    }
+    inline bool equals(char const * str) const {
+      return equals(str, strlen(str));
+    }
+    inline bool equals(CborStringView const & other) const {
+      return equals(other._data, other._length);
+    }
+    /* Returns the position of the first occurrence of c or -1 */
+    inline int indexOf(char const c) const {
+      char const * pos = static_cast<char const *>(memchr(_data, c, _length));
+      return (pos != nullptr) ? static_cast<int>(pos - _data) : -1;
+    }
+    inline CborStringView prefix(size_t const length) const {
+      return CborStringView(_data, (length < _length) ? length : _length);
+    }
+    inline CborStringView suffix(size_t const pos) const {
+      return (pos < _length) ? CborStringView(_data + pos, _length - pos) : CborStringView();
+    }
+    inline String toString() const {
+      return String(_data, _length);
+    }
+
+  private:
+    char const * _data;
+    size_t       _length;
+};
+
+/* Name given to a property when it is registered. A string literal, as well as
+ * any other string outliving the property, is referenced in place so that it
+ * stays in flash. A String is copied once, at registration, since it does not
+ * outlive the call.
+ */
+class PropertyName {
+
+  public:
+    PropertyName(char const * name) : _name{name}, _string{nullptr} { }
+    PropertyName(String const & name) : _name{name.c_str()}, _string{&name} { }
+
+    inline char const * c_str()  const { return _name; }
+    inline size_t       length() const { return strlen(_name); }
+    /* Returns a name valid as long as the property, nullptr if out of memory */
+    char const * persist() const;
+
+  private:
+    char const *   _name;
+    String const * _string;
+};
+
 class CborMapData {
 
   public:
-    MapEntry<int>    base_version;
-    MapEntry<String> base_name;
-    MapEntry<double> base_time;
-    MapEntry<String> name;
-    MapEntry<int>    name_identifier;
-    MapEntry<bool>   light_payload;
-    MapEntry<String> attribute_name;
-    MapEntry<int>    attribute_identifier;
-    MapEntry<int>    property_identifier;
-    MapEntry<double> val;
-    MapEntry<String> str_val;
-    MapEntry<bool>   bool_val;
-    MapEntry<double> time;
+    MapEntry<int>            base_version;
+    MapEntry<CborStringView> base_name;
+    MapEntry<double>         base_time;
+    MapEntry<CborStringView> name;
+    MapEntry<bool>           light_payload;
+    MapEntry<CborStringView> attribute_name;
+    MapEntry<int>            attribute_identifier;
+    MapEntry<double>         val;
+    MapEntry<CborStringView> str_val;
+    MapEntry<bool>           bool_val;
+    MapEntry<double>         time;
 };
 
-enum class Permission {
+/* Records of a property decoded from a message, kept in fixed capacity storage
+ * on the stack of the decoder. A record replaces the earlier record of the same
+ * attribute. push_back() fails for records of more attributes than the
+ * capacity, which is above the number of attributes of any property type. The
+ * records are indexed when added, by attribute identifier for light payloads
+ * and by hash of the attribute name otherwise, so that every attribute of the
+ * property is looked up directly instead of comparing it with all the records.
+ */
+class CborMapDataList {
+
+  public:
+    CborMapDataList() : _size{0} { clear(); }
+
+    typedef CborMapData *       iterator;
+    typedef CborMapData const * const_iterator;
+
+    inline iterator       begin()       { return _records; }
+    inline iterator       end()         { return _records + _size; }
+    inline const_iterator begin() const { return _records; }
+    inline const_iterator end()   const { return _records + _size; }
+    inline size_t         size()  const { return _size; }
+    inline bool           empty() const { return _size == 0; }
+
+    void clear();
+    bool push_back(CborMapData const & map_data);
+    /* Returns the record of the attribute or nullptr */
+    CborMapData * find(int const attribute_identifier, char const * attribute_name);
+
+    static size_t const CAPACITY = 8;
+
+  private:
+    /* Slots hold the index of the record plus one, 0 for an empty slot */
+    static size_t const NAME_INDEX_SIZE = 2 * CAPACITY;
+
+    CborMapData _records[CAPACITY];
+    size_t      _size;
+    uint8_t     _identifier_index[CAPACITY];
+    uint8_t     _name_index[NAME_INDEX_SIZE];
+    uint32_t    _name_hash[NAME_INDEX_SIZE];
+
+    static uint32_t hashName(char const * name, size_t const length);
+};
+
+/* SenML base fields in effect while a message is encoded with base
+ * compression (RFC 8428, section 4.1): every property opens with its name as
+ * base name, its attributes follow with relative names and the base time is
+ * written only when it changes.
+ */
+class SenMLBase {
+
+  public:
+    SenMLBase() : base_time{0} { }
+
+    inline void reset() {
+      base_time = 0;
+    }
+
+    /* Base time inherited by the following records, 0 if none */
+    unsigned long base_time;
+};
+
+/* Integer identifier replacing the "name:attribute" key in light payloads.
+ * Property identifiers below 256 use the legacy layout attribute * 256 + id,
+ * larger ones (up to 65535) use (attribute + 1) * 65536 + id which is never
+ * produced by the legacy layout, hence both can be told apart when decoding.
+ */
+namespace LightPayloadIdentifier
+{
+  static int const LEGACY_IDENTIFIER_LIMIT = 256;
+  static int const WIDE_IDENTIFIER_LIMIT = 65536;
+
+  inline int compose(int const identifier, int const attribute) {
+    return (identifier < LEGACY_IDENTIFIER_LIMIT) ? (attribute * LEGACY_IDENTIFIER_LIMIT + identifier)
+                                                  : ((attribute + 1) * WIDE_IDENTIFIER_LIMIT + identifier);
+  }
+  inline int property(int const light_identifier) {
+    return (light_identifier < WIDE_IDENTIFIER_LIMIT) ? (light_identifier % LEGACY_IDENTIFIER_LIMIT)
+                                                      : (light_identifier % WIDE_IDENTIFIER_LIMIT);
+  }
+  inline int attribute(int const light_identifier) {
+    return (light_identifier < WIDE_IDENTIFIER_LIMIT) ? (light_identifier / LEGACY_IDENTIFIER_LIMIT)
+                                                      : (light_identifier / WIDE_IDENTIFIER_LIMIT - 1);
+  }
+}
+
+enum class Permission : uint8_t {
   Read, Write, ReadWrite
 };
 
@@ -121,18 +268,50 @@ enum class Type {
   Bool, Int, Float, String
 };
 
-enum class UpdatePolicy {
+enum class UpdatePolicy : uint8_t {
   OnChange, TimeInterval, OnDemand
 };
 
-enum class WritePolicy {
+enum class WritePolicy : uint8_t {
   Auto, Manual
 };
 
+/* Priority class of a property: the dirty properties of the High class are
+ * packed into a message before any property of the Normal class.
+ */
+enum class Priority : uint8_t {
+  Normal, High
+};
+
 typedef void(*UpdateCallbackFunc)(void);
 typedef unsigned long(*GetTimeCallbackFunc)();
 class Property;
 typedef void(*OnSyncCallbackFunc)(Property &);
+class PropertyContainer;
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Link between a property and the container it has been registered in, used to
+ * keep track of the properties that need to be checked by the encoder and of the
+ * time at which a property waiting for its update interval has to be checked
+ * again. The link is not propagated by copies: temporaries created by the
+ * operators of the Cloud* types must never take part in the accounting of the
+ * container.
+ */
+class PropertyContainerLink
+{
+  public:
+    PropertyContainerLink() : container{nullptr}, dirty{false}, scheduled{false}, due_millis{0} { }
+    PropertyContainerLink(PropertyContainerLink const &) : container{nullptr}, dirty{false}, scheduled{false}, due_millis{0} { }
+    PropertyContainerLink & operator = (PropertyContainerLink const &) { return (*this); }
+
+    PropertyContainer * container;
+    bool                dirty;
+    bool                scheduled;
+    unsigned long       due_millis;
+};
 
 /******************************************************************************
    CLASS DECLARATION
@@ -143,7 +322,7 @@ class Property
   public:
     Property();
     virtual ~Property() {}
-    void init(String const name, Permission const permission, GetTimeCallbackFunc func);
+    void init(char const * name, Permission const permission, GetTimeCallbackFunc func);
 
     /* Composable configuration of the Property class */
     Property & onUpdate(UpdateCallbackFunc func);
@@ -154,8 +333,9 @@ class Property
     Property & encodeTimestamp();
     Property & writeOnChange();
     Property & writeOnDemand();
+    Property & priority(Priority const priority);
 
-    inline String name() const {
+    inline char const * name() const {
       return _name;
     }
     inline int identifier() const {
@@ -170,6 +350,9 @@ class Property
     inline bool   isWritableOnChange() const {
       return _write_policy == WritePolicy::Auto;
     }
+    inline bool   isHighPriority() const {
+      return _high_priority;
+    }
 
     void setTimestamp(unsigned long const timestamp);
     bool shouldBeUpdated();
@@ -183,22 +366,67 @@ class Property
     unsigned long getLastCloudChangeTimestamp();
     unsigned long getLastLocalChangeTimestamp();
     void setIdentifier(int identifier);
-
-    void updateLocalTimestamp();
-    CborError append(CborEncoder * encoder, bool lightPayload);
-    CborError appendAttribute(bool value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(int value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(unsigned int value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(float value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(String value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttributeName(String attributeName, std::function<CborError (CborEncoder& mapEncoder)>f, CborEncoder *encoder);
-    void setAttribute(String attributeName, std::function<void (CborMapData & md)>setValue);
-    void setAttributesFromCloud(std::list<CborMapData> * map_data_list);
-    void setAttribute(bool& value, String attributeName = "");
-    void setAttribute(int& value, String attributeName = "");
-    void setAttribute(unsigned int& value, String attributeName = "");
-    void setAttribute(float& value, String attributeName = "");
-    void setAttribute(String& value, String attributeName = "");
+    void setContainer(PropertyContainer * container);
+    inline PropertyContainer * getContainer() const { return _link.container; }
+
+    /* A property is dirty when it may have to be sent to the cloud. Setters of
+     * the Cloud* types, update/echo requests and values received from the cloud
+     * mark it dirty, the encoder clears it once there is nothing left to send.
+     * A property waiting for its update interval or for the minimum time between
+     * updates is scheduled in the container and marked dirty again when the
+     * time is due. Primitive wrappers cannot signal writes to the wrapped
+     * variable, they are marked dirty by the container polling them.
+     */
+    inline bool isDirty() const {
+      return _link.dirty;
+    }
+    void handleScheduledUpdate(unsigned long const due_millis);
+
+    /* Called by every local write of the value */
+    virtual void updateLocalTimestamp();
+    /* Appends the records of the property to the message. If senmlBase is
+     * provided the records are compressed using the SenML base name and base
+     * time fields, see SenMLBase. If compactFloats is true float attributes are
+     * encoded as small integers when integral, or as half precision floats when
+     * the loss of precision does not exceed the minimum delta of the property.
+     */
+    CborError append(CborEncoder * encoder, bool lightPayload, SenMLBase * senmlBase = nullptr, bool compactFloats = false);
+    /* append() split in its two steps: encode() only writes the records of the
+     * property, with the same parameters as append(), and markAppended() updates
+     * the property state once the records are part of the message. A caller may
+     * discard what encode() wrote, e.g. when the property does not fit into the
+     * message, without side effects. If timestamped is true every record carries
+     * the time of the last local change of the value, unless a timestamp has been
+     * set, e.g. for values stored while disconnected and sent later.
+     */
+    CborError encode(CborEncoder * encoder, bool lightPayload, SenMLBase * senmlBase = nullptr, bool compactFloats = false, bool timestamped = false);
+    void markAppended();
+    /* markAppended() for records stored while disconnected to be sent later: the
+     * property is throttled as if they had been sent, but appendCompleted() is
+     * only called once they have been written to the cloud. storeDropped() is
+     * called instead if they are lost, the property is then sent again.
+     */
+    void markStored();
+    void storeDropped();
+    inline bool isStored() const {
+      return _has_been_stored_but_not_sended;
+    }
+    /* Attribute names are expected to be string literals: they are neither
+     * copied nor concatenated with the property name on the heap.
+     */
+    CborError appendAttribute(bool value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(int value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(unsigned int value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(float value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(String const & value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttributeName(char const * attributeName, std::function<CborError (CborEncoder& mapEncoder)>f, CborEncoder *encoder);
+    void setAttribute(char const * attributeName, std::function<void (CborMapData & md)>setValue);
+    void setAttributesFromCloud(CborMapDataList * map_data_list);
+    void setAttribute(bool& value, char const * attributeName = "");
+    void setAttribute(int& value, char const * attributeName = "");
+    void setAttribute(unsigned int& value, char const * attributeName = "");
+    void setAttribute(float& value, char const * attributeName = "");
+    void setAttribute(String& value, char const * attributeName = "");
 
     virtual bool isDifferentFromCloud() = 0;
     virtual void fromCloudToLocal() = 0;
@@ -208,45 +436,100 @@ class Property
     virtual bool isPrimitive() {
       return false;
     };
+    /* Values of a property keeping its history are all sent, otherwise a value
+     * not sent yet may be superseded by a newer one.
+     */
+    virtual bool keepsHistory() {
+      return _encode_timestamp;
+    }
 
     static unsigned long const DEFAULT_MIN_TIME_BETWEEN_UPDATES_MILLIS = 500; /* Data rate throttled to 2 Hz */
+    /* Longest "name:attribute" key composed on the stack while encoding */
+    static size_t const MAX_ATTRIBUTE_KEY_LENGTH = 64;
+    /* Longest name accepted at registration, leaving room for the separator
+     * and the longest attribute name ("sat", "swi", "vol")
+     */
+    static size_t const MAX_NAME_LENGTH = MAX_ATTRIBUTE_KEY_LENGTH - 4;
 
   protected:
+    /* Appends the record of a value sampled time_offset seconds after base_time,
+     * used by properties sending several samples per update (see CloudTimeSeries).
+     * With SenML base compression the first record carries the base name and the
+     * base time and the following ones only the value and the relative time,
+     * otherwise every record carries the name and the absolute time.
+     */
+    template <typename T>
+    CborError appendSample(T const & value, unsigned long const base_time, float const time_offset, bool const first_sample, CborEncoder * encoder) {
+      return appendSampleRecord(base_time, time_offset, first_sample, [this, &value](CborEncoder & mapEncoder)
+      {
+        return appendValue(mapEncoder, value);
+      }, encoder);
+    }
+
     /* Variables used for UpdatePolicy::OnChange */
-    String             _name;
+    char const *       _name;
     float              _min_delta_property;
     unsigned long      _min_time_between_updates_millis;
 
   private:
-    Permission         _permission;
-    WritePolicy        _write_policy;
-    GetTimeCallbackFunc _get_time_func;
-    UpdateCallbackFunc _update_callback_func;
-    OnSyncCallbackFunc _on_sync_callback_func;
-
-    UpdatePolicy       _update_policy;
-    bool               _has_been_updated_once,
-                       _has_been_modified_in_callback,
-                       _has_been_appended_but_not_sended;
+    CborError appendName(CborEncoder * mapEncoder, char const * separator, char const * attributeName);
+    CborError appendValue(CborEncoder & mapEncoder, bool const value);
+    CborError appendValue(CborEncoder & mapEncoder, int const value);
+    CborError appendValue(CborEncoder & mapEncoder, unsigned int const value);
+    CborError appendValue(CborEncoder & mapEncoder, float const value);
+    CborError appendValue(CborEncoder & mapEncoder, String const & value);
+    CborError appendFloatValue(CborEncoder & mapEncoder, float const value);
+    CborError appendCompressedAttributeName(char const * attributeName, std::function<CborError (CborEncoder& mapEncoder)>appendValue, CborEncoder *encoder);
+    CborError appendSampleRecord(unsigned long const base_time, float const time_offset, bool const first_sample, std::function<CborError (CborEncoder& mapEncoder)>appendValue, CborEncoder *encoder);
+    /* Time encoded with the records of the property, 0 if none */
+    unsigned long recordTime() const;
+    void markDirty();
+    void clearDirty();
+    void scheduleUpdate(unsigned long const due_millis);
+
+    /* Members checked on every update cycle are kept together at the top,
+     * configuration and synchronization state follows.
+     */
     /* Variables used for UpdatePolicy::TimeInterval */
     unsigned long      _last_updated_millis,
                        _update_interval_millis;
-    /* Variables used for reconnection sync*/
-    unsigned long      _last_local_change_timestamp;
-    unsigned long      _last_cloud_change_timestamp;
-    std::list<CborMapData> * _map_data_list;
+    unsigned long      _timestamp;
     /* Store the identifier of the property in the array list */
     int                _identifier;
-    int                _attributeIdentifier;
+    Permission         _permission;
+    WritePolicy        _write_policy;
+    UpdatePolicy       _update_policy;
+    uint8_t            _attributeIdentifier;
+    bool               _has_been_updated_once            : 1,
+                       _has_been_modified_in_callback    : 1,
+                       _has_been_appended_but_not_sended : 1,
+                       _has_been_stored_but_not_sended   : 1,
     /* Indicates if the property shall be encoded using the identifier instead of the name */
-    bool               _lightPayload;
+                       _lightPayload                     : 1,
     /* Indicates whether a property update has been requested in case of the OnDemand update policy. */
-    bool               _update_requested;
+                       _update_requested                 : 1,
     /* Indicates whether the timestamp shall be encoded in the property or not */
-    bool               _encode_timestamp;
+                       _encode_timestamp                 : 1,
     /* Indicates if the property shall be echoed back to the cloud even if unchanged */
-    bool               _echo_requested;
-    unsigned long      _timestamp;
+                       _echo_requested                   : 1,
+    /* Indicates if float attributes may be encoded as integers or half precision floats */
+                       _compact_floats                   : 1,
+    /* Indicates if the time of the last local change shall be encoded */
+                       _encode_change_timestamp          : 1,
+    /* Indicates if the property belongs to the Priority::High class */
+                       _high_priority                    : 1;
+
+    GetTimeCallbackFunc _get_time_func;
+    UpdateCallbackFunc _update_callback_func;
+    OnSyncCallbackFunc _on_sync_callback_func;
+    /* Variables used for reconnection sync*/
+    unsigned long      _last_local_change_timestamp;
+    unsigned long      _last_cloud_change_timestamp;
+    CborMapDataList *  _map_data_list;
+    /* SenML base fields of the message being encoded, only set within encode() */
+    SenMLBase *        _senml_base;
+    /* Registration container and dirty state */
+    PropertyContainerLink _link;
 };
 
 /******************************************************************************
@@ -254,7 +537,7 @@ class Property
  ******************************************************************************/
 
 inline bool operator == (Property const & lhs, Property const & rhs) {
-  return (lhs.name() == rhs.name());
+  return (strcmp(lhs.name(), rhs.name()) == 0);
 }
 
 /******************************************************************************
@@ -0,0 +1,65 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2024 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "PropertyArena.h"
+
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+PropertyArena::PropertyArena(uint8_t * buffer, size_t const capacity)
+: _buffer{buffer}
+, _capacity{capacity}
+, _used{0}
+, _overflow{0}
+{
+
+}
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void * PropertyArena::allocate(size_t const size, size_t const alignment)
+{
+  uintptr_t const begin = reinterpret_cast<uintptr_t>(_buffer) + _used;
+  size_t const padding = (alignment - (begin % alignment)) % alignment;
+  size_t const required = _used + padding + size;
+
+  if (required > _capacity)
+  {
+    /* Keep track of the demand so that the arena can be sized accordingly */
+    _overflow += padding + size;
+    return nullptr;
+  }
+
+  _used = required;
+  return reinterpret_cast<void *>(begin + padding);
+}
+
+/******************************************************************************
+   EXTERN DEFINITION
+ ******************************************************************************/
+
+#if AIOT_CONFIG_PROPERTY_ARENA_BYTES > 0
+alignas(max_align_t) static uint8_t property_wrapper_arena_buffer[AIOT_CONFIG_PROPERTY_ARENA_BYTES];
+PropertyArena PropertyWrapperArena(property_wrapper_arena_buffer, sizeof(property_wrapper_arena_buffer));
+#endif
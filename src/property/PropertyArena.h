@@ -0,0 +1,91 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2024 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_PROPERTY_ARENA_H_
+#define ARDUINO_PROPERTY_ARENA_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+#include "Property.h"
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Bump allocator placing the property wrappers created by the library next to
+ * each other in a statically sized buffer. Properties are never unregistered,
+ * therefore memory is never given back and the arena does not fragment.
+ */
+class PropertyArena
+{
+  public:
+    PropertyArena(uint8_t * buffer, size_t const capacity);
+
+    /* Returns nullptr if the arena can not hold the requested object */
+    void * allocate(size_t const size, size_t const alignment);
+
+    inline size_t capacity()      const { return _capacity; }
+    inline size_t used()          const { return _used; }
+    /* Bytes that would have been needed to satisfy every allocation request,
+     * failed ones included: use it to size AIOT_CONFIG_PROPERTY_ARENA_BYTES.
+     */
+    inline size_t highWaterMark() const { return _used + _overflow; }
+
+  private:
+    uint8_t * _buffer;
+    size_t    _capacity;
+    size_t    _used;
+    size_t    _overflow;
+};
+
+/******************************************************************************
+   EXTERN DECLARATION
+ ******************************************************************************/
+
+#if AIOT_CONFIG_PROPERTY_ARENA_BYTES > 0
+extern PropertyArena PropertyWrapperArena;
+#endif
+
+/******************************************************************************
+   FUNCTION DEFINITION
+ ******************************************************************************/
+
+/* Creates the wrapper of a primitive variable either in the property arena, if
+ * enabled, or on the heap. Returns nullptr if no memory is left.
+ */
+template <typename WrapperType, typename ValueType>
+Property * createPropertyWrapper(ValueType & value)
+{
+#if AIOT_CONFIG_PROPERTY_ARENA_BYTES > 0
+  void * mem = PropertyWrapperArena.allocate(sizeof(WrapperType), alignof(WrapperType));
+  if (mem == nullptr)
+    return nullptr;
+  return new (mem) WrapperType(value);
+#else
+  return new (std::nothrow) WrapperType(value);
+#endif
+}
+
+#endif /* ARDUINO_PROPERTY_ARENA_H_ */
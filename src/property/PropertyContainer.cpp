@@ -31,56 +31,262 @@
 
 void addProperty(PropertyContainer & prop_cont, Property * property_obj, int propertyIdentifier);
 
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+PropertyContainer::PropertyContainer()
+: _properties{}
+, _name_index{}
+, _identifier_index{}
+, _primitive_properties{}
+, _high_priority_properties{}
+, _high_priority_index{0}
+, _dirty_count{0}
+, _schedule{}
+{
+
+}
+
+PropertyContainer::~PropertyContainer()
+{
+  /* Properties outlive their container: keep their dirty state for the next one */
+  for (Property * property : _properties) {
+    if (property->getContainer() == this) {
+      property->setContainer(nullptr);
+    }
+  }
+}
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void PropertyContainer::push_back(Property * property)
+{
+  /* Keep the load factor of the indices at or below 50 % so that probe
+   * sequences stay short. Growing only happens during registration.
+   */
+  if (2 * (_properties.size() + 1) > _name_index.size())
+    rehash(_name_index.empty() ? MIN_INDEX_CAPACITY : 2 * _name_index.size());
+
+  _properties.push_back(property);
+  insertIntoIndex(property);
+
+  if (property->isPrimitive())
+    _primitive_properties.push_back(property);
+  if (property->isHighPriority())
+    _high_priority_properties.push_back(property);
+  property->setContainer(this);
+}
+
+void PropertyContainer::updatePriority(Property * property)
+{
+  /* Only called when the priority class of the property has changed: a high
+   * priority property is not listed yet, a normal one is.
+   */
+  if (property->isHighPriority()) {
+    _high_priority_properties.push_back(property);
+  } else {
+    _high_priority_properties.erase(std::remove(_high_priority_properties.begin(), _high_priority_properties.end(), property), _high_priority_properties.end());
+    _high_priority_index = 0;
+  }
+}
+
+void PropertyContainer::reserve(size_t const additional_count)
+{
+  size_t const count = _properties.size() + additional_count;
+  _properties.reserve(count);
+
+  size_t capacity = _name_index.empty() ? MIN_INDEX_CAPACITY : _name_index.size();
+  while (2 * count > capacity)
+    capacity *= 2;
+  if (capacity > _name_index.size())
+    rehash(capacity);
+}
+
+void PropertyContainer::schedule(Property * property, unsigned long const due_millis)
+{
+  _schedule.push_back(ScheduleEntry{due_millis, property});
+  std::push_heap(_schedule.begin(), _schedule.end(), isLater);
+}
+
+void PropertyContainer::markDueProperties(unsigned long const now_millis)
+{
+  /* The earliest deadline is on top of the heap, an update cycle in which no
+   * deadline has expired costs a single comparison.
+   */
+  while (!_schedule.empty() && !isLater(_schedule.front(), ScheduleEntry{now_millis, nullptr}))
+  {
+    ScheduleEntry const entry = _schedule.front();
+    std::pop_heap(_schedule.begin(), _schedule.end(), isLater);
+    _schedule.pop_back();
+    entry.property->handleScheduledUpdate(entry.due_millis);
+  }
+}
+
+Property * PropertyContainer::find(char const * name) const
+{
+  return find(CborStringView(name, strlen(name)));
+}
+
+Property * PropertyContainer::find(CborStringView const & name) const
+{
+  if (_name_index.empty())
+    return nullptr;
+
+  size_t const mask = _name_index.size() - 1;
+  uint32_t const hash = hashName(name.data(), name.length());
+
+  for (size_t i = hash & mask; _name_index[i].property != nullptr; i = (i + 1) & mask)
+  {
+    if (_name_index[i].hash == hash && name.equals(_name_index[i].property->name()))
+      return _name_index[i].property;
+  }
+  return nullptr;
+}
+
+Property * PropertyContainer::find(int const identifier) const
+{
+  if (_identifier_index.empty())
+    return nullptr;
+
+  size_t const mask = _identifier_index.size() - 1;
+  uint32_t const hash = hashIdentifier(identifier);
+
+  for (size_t i = hash & mask; _identifier_index[i].property != nullptr; i = (i + 1) & mask)
+  {
+    if (_identifier_index[i].property->identifier() == identifier)
+      return _identifier_index[i].property;
+  }
+  return nullptr;
+}
+
+/******************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void PropertyContainer::rehash(size_t const capacity)
+{
+  _name_index.assign(capacity, IndexSlot{0, nullptr});
+  _identifier_index.assign(capacity, IndexSlot{0, nullptr});
+
+  for (Property * p : _properties)
+    insertIntoIndex(p);
+}
+
+void PropertyContainer::insertIntoIndex(Property * property)
+{
+  size_t const mask = _name_index.size() - 1;
+
+  /* If an entry with the same key is already present the first registered
+   * property wins, matching the behaviour of a linear search from the front.
+   */
+  uint32_t const name_hash = hashName(property->name(), strlen(property->name()));
+  size_t i = name_hash & mask;
+  for (; _name_index[i].property != nullptr; i = (i + 1) & mask)
+  {
+    if (_name_index[i].hash == name_hash && *_name_index[i].property == *property)
+      break;
+  }
+  if (_name_index[i].property == nullptr)
+    _name_index[i] = IndexSlot{name_hash, property};
+
+  uint32_t const id_hash = hashIdentifier(property->identifier());
+  i = id_hash & mask;
+  for (; _identifier_index[i].property != nullptr; i = (i + 1) & mask)
+  {
+    if (_identifier_index[i].property->identifier() == property->identifier())
+      break;
+  }
+  if (_identifier_index[i].property == nullptr)
+    _identifier_index[i] = IndexSlot{id_hash, property};
+}
+
+/* Wrap-around safe comparison of millis() based deadlines */
+bool PropertyContainer::isLater(ScheduleEntry const & lhs, ScheduleEntry const & rhs)
+{
+  return static_cast<long>(lhs.due_millis - rhs.due_millis) > 0;
+}
+
+/* 32 bit FNV-1a */
+uint32_t PropertyContainer::hashName(char const * name, size_t const length)
+{
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < length; i++)
+  {
+    hash ^= static_cast<uint8_t>(name[i]);
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+/* Knuth multiplicative hashing */
+uint32_t PropertyContainer::hashIdentifier(int const identifier)
+{
+  return static_cast<uint32_t>(identifier) * 2654435761UL;
+}
+
 /******************************************************************************
    PUBLIC FUNCTION DEFINITION
  ******************************************************************************/
 
-Property & addPropertyToContainer(PropertyContainer & prop_cont, Property & property, String const & name, Permission const permission, int propertyIdentifier, GetTimeCallbackFunc func)
+Property & addPropertyToContainer(PropertyContainer & prop_cont, Property & property, PropertyName const & name, Permission const permission, int propertyIdentifier, GetTimeCallbackFunc func)
 {
   /* Check whether or not the property already has been added to the container */
   Property * p = getProperty(prop_cont, name);
   if(p != nullptr) return (*p);
 
+  /* A name too long to be encoded with its attributes is not registered */
+  if (name.length() > Property::MAX_NAME_LENGTH) return property;
+
+  char const * const persistent_name = name.persist();
+  if (persistent_name == nullptr) return property;
+
   /* Initialize property and add it to the container */
-  property.init(name, permission, func);
+  property.init(persistent_name, permission, func);
 
   addProperty(prop_cont, &property, propertyIdentifier);
   return property;
 }
 
-
-Property * getProperty(PropertyContainer & prop_cont, String const & name)
+void addPropertiesToContainer(PropertyContainer & prop_cont, PropertyDescriptor const * descriptors, size_t const count, GetTimeCallbackFunc func)
 {
-  std::list<Property *>::iterator iter;
+  /* Allocate once for the whole table, duplicates are detected by the
+   * hash index lookup of addPropertyToContainer.
+   */
+  prop_cont.reserve(count);
 
-  iter = std::find_if(prop_cont.begin(),
-                      prop_cont.end(),
-                      [name](Property * p) -> bool
-                      {
-                        return (p->name() == name);
-                      });
+  for (size_t i = 0; i < count; i++)
+  {
+    PropertyDescriptor const & d = descriptors[i];
+    Property & property = addPropertyToContainer(prop_cont, *d.property, d.name, d.permission, d.identifier, func);
 
-  if (iter == prop_cont.end())
-    return nullptr;
-  else
-    return (*iter);
+    /* Do not reconfigure the property already registered under the same name,
+     * nor one whose name has been rejected
+     */
+    if (&property != d.property || property.getContainer() != &prop_cont)
+      continue;
+
+    if (d.update_policy == UpdatePolicy::TimeInterval) {
+      property.publishEvery(d.update_parameter);
+    } else if (d.update_policy == UpdatePolicy::OnDemand) {
+      property.publishOnDemand();
+    } else {
+      property.publishOnChange(d.min_delta, d.update_parameter);
+    }
+    property.onUpdate(d.update_callback).onSync(d.sync_callback).priority(d.priority_class);
+  }
 }
 
-Property * getProperty(PropertyContainer & prop_cont, int const identifier)
+Property * getProperty(PropertyContainer & prop_cont, PropertyName const & name)
 {
-  std::list<Property *>::iterator iter;
-
-  iter = std::find_if(prop_cont.begin(),
-                      prop_cont.end(),
-                      [identifier](Property * p) -> bool
-                      {
-                        return (p->identifier() == identifier);
-                      });
+  return prop_cont.find(name.c_str());
+}
 
-  if (iter == prop_cont.end())
-    return nullptr;
-  else
-    return (*iter);
+Property * getProperty(PropertyContainer & prop_cont, int const identifier)
+{
+  return prop_cont.find(identifier);
 }
 
 void requestUpdateForAllProperties(PropertyContainer & prop_cont)
@@ -96,23 +302,31 @@ void requestUpdateForAllProperties(PropertyContainer & prop_cont)
 void updateTimestampOnLocallyChangedProperties(PropertyContainer & prop_cont)
 {
   /* This function updates the timestamps on the primitive properties
-   * that have been modified locally since last cloud synchronization
+   * that have been modified locally since last cloud synchronization,
+   * which marks them dirty. A change is observed once: a wrapper waiting
+   * for its minimum time between updates is not marked again until its
+   * variable changes again or its deadline expires.
    */
-  std::for_each(prop_cont.begin(),
-                prop_cont.end(),
+  std::for_each(prop_cont.primitiveProperties().begin(),
+                prop_cont.primitiveProperties().end(),
                 [](Property * p)
                 {
-                  CloudWrapperBase * pbase = reinterpret_cast<CloudWrapperBase *>(p);
-                  if (pbase->isPrimitive() && pbase->isChangedLocally() && pbase->isReadableByCloud())
+                  CloudWrapperBase * pbase = static_cast<CloudWrapperBase *>(p);
+                  if (pbase->isChangedLocally())
                   {
-                    p->updateLocalTimestamp();
+                    pbase->fromPrimitiveToLocal();
+                    if (pbase->isDifferentFromCloud() && pbase->isReadableByCloud())
+                      p->updateLocalTimestamp();
                   }
                 });
+
+  /* Properties whose deadline has expired are due for an update */
+  prop_cont.markDueProperties(millis());
 }
 
-void updateProperty(PropertyContainer & prop_cont, String propertyName, unsigned long cloudChangeEventTime, bool const is_sync_message, std::list<CborMapData> * map_data_list)
+void updateProperty(PropertyContainer & prop_cont, CborStringView const & propertyName, unsigned long cloudChangeEventTime, bool const is_sync_message, CborMapDataList * map_data_list)
 {
-  Property * property = getProperty(prop_cont, propertyName);
+  Property * property = prop_cont.find(propertyName);
 
   if (property && property->isWriteableByCloud())
   {
@@ -132,15 +346,10 @@ void updateProperty(PropertyContainer & prop_cont, String propertyName, unsigned
 
 String getPropertyNameByIdentifier(PropertyContainer & prop_cont, int propertyIdentifier)
 {
-  Property * property = nullptr;
-
-  if (propertyIdentifier > 255)
-    property = getProperty(prop_cont, propertyIdentifier & 255);
-  else
-    property = getProperty(prop_cont, propertyIdentifier);
+  Property * property = getProperty(prop_cont, LightPayloadIdentifier::property(propertyIdentifier));
 
   if (property)
-    return property->name();
+    return String(property->name());
   else
     return String("");
 }
@@ -25,10 +25,11 @@
 #include <Arduino.h>
 
 #include "Property.h"
+#include "PropertyDescriptor.h"
 
 #undef max
 #undef min
-#include <list>
+#include <vector>
 
 #include "types/CloudBool.h"
 #include "types/CloudFloat.h"
@@ -38,6 +39,7 @@
 #include "types/CloudLocation.h"
 #include "types/CloudSchedule.h"
 #include "types/CloudColor.h"
+#include "types/CloudTimeSeries.h"
 #include "types/CloudWrapperBase.h"
 
 #include "types/automation/CloudColoredLight.h"
@@ -57,10 +59,102 @@
 extern "C" unsigned long getTime();
 
 /******************************************************************************
-   TYPEDEF
+   CLASS DECLARATION
  ******************************************************************************/
 
-typedef std::list<Property *> PropertyContainer;
+/* The property container keeps the properties in registration order, which
+ * is the order used by the encoder, in a contiguous array. It maintains two
+ * open addressing hash indices (by name and by integer identifier) built at
+ * registration time so that looking up a property while decoding does not
+ * require a linear scan. It also counts its dirty properties so that an
+ * update cycle in which nothing has changed can be skipped without visiting
+ * any property, and keeps a min-heap of the times at which properties waiting
+ * for their update interval or rate limit have to be checked again.
+ */
+class PropertyContainer
+{
+  public:
+    typedef std::vector<Property *>::iterator       iterator;
+    typedef std::vector<Property *>::const_iterator const_iterator;
+
+    PropertyContainer();
+    ~PropertyContainer();
+
+    inline iterator       begin()       { return _properties.begin(); }
+    inline iterator       end()         { return _properties.end(); }
+    inline const_iterator begin() const { return _properties.begin(); }
+    inline const_iterator end()   const { return _properties.end(); }
+    inline size_t         size()  const { return _properties.size(); }
+    inline bool           empty() const { return _properties.empty(); }
+    /* Random access used by the encoder to resume from the property following
+     * the last one sent without walking the container from the beginning.
+     */
+    inline Property *     operator [] (size_t const index) const { return _properties[index]; }
+
+    void push_back(Property * property);
+    /* Prepares the container for the registration of further properties so
+     * that storage and indices are allocated once instead of growing.
+     */
+    void reserve(size_t const additional_count);
+
+    inline bool hasDirtyProperties() const { return _dirty_count > 0; }
+    inline void incrementDirtyCount()      { _dirty_count++; }
+    inline void decrementDirtyCount()      { _dirty_count--; }
+
+    void schedule(Property * property, unsigned long const due_millis);
+    /* Called once per update cycle by updateTimestampOnLocallyChangedProperties */
+    void markDueProperties(unsigned long const now_millis);
+
+    /* Primitive wrappers can not signal local changes and need to be polled */
+    inline std::vector<Property *> & primitiveProperties() { return _primitive_properties; }
+
+    /* Properties of the Priority::High class, packed first by the encoder starting
+     * from the one at highPriorityIndex() so that none of them is left behind.
+     */
+    inline std::vector<Property *> & highPriorityProperties() { return _high_priority_properties; }
+    inline size_t & highPriorityIndex() { return _high_priority_index; }
+    void updatePriority(Property * property);
+
+    Property * find(char const * name) const;
+    Property * find(CborStringView const & name) const;
+    Property * find(int const identifier) const;
+
+  private:
+
+    struct IndexSlot
+    {
+      uint32_t   hash;
+      Property * property;
+    };
+
+    struct ScheduleEntry
+    {
+      unsigned long due_millis;
+      Property *    property;
+    };
+
+    static size_t const MIN_INDEX_CAPACITY = 8;
+
+    std::vector<Property *> _properties;
+    std::vector<IndexSlot> _name_index;
+    std::vector<IndexSlot> _identifier_index;
+    std::vector<Property *> _primitive_properties;
+    std::vector<Property *> _high_priority_properties;
+    size_t _high_priority_index;
+    size_t _dirty_count;
+    std::vector<ScheduleEntry> _schedule;
+
+    void rehash(size_t const capacity);
+    void insertIntoIndex(Property * property);
+
+    static bool isLater(ScheduleEntry const & lhs, ScheduleEntry const & rhs);
+    static uint32_t hashName(char const * name, size_t const length);
+    static uint32_t hashIdentifier(int const identifier);
+};
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
 
 typedef CloudFloat CloudEnergy;
 typedef CloudFloat CloudForce;
@@ -99,19 +193,23 @@ typedef CloudFloat CloudRelativeHumidity;
 
 Property & addPropertyToContainer(PropertyContainer & prop_cont,
                                   Property & property,
-                                  String const & name,
+                                  PropertyName const & name,
                                   Permission const permission,
                                   int propertyIdentifier = -1,
                                   GetTimeCallbackFunc func = getTime);
 
-  
-Property * getProperty(PropertyContainer & prop_cont, String const & name);
+void addPropertiesToContainer(PropertyContainer & prop_cont,
+                              PropertyDescriptor const * descriptors,
+                              size_t const count,
+                              GetTimeCallbackFunc func = getTime);
+
+Property * getProperty(PropertyContainer & prop_cont, PropertyName const & name);
 Property * getProperty(PropertyContainer & prop_cont, int const identifier);
 
 
 void updateTimestampOnLocallyChangedProperties(PropertyContainer & prop_cont);
 void requestUpdateForAllProperties(PropertyContainer & prop_cont);
-void updateProperty(PropertyContainer & prop_cont, String propertyName, unsigned long cloudChangeEventTime, bool const is_sync_message, std::list<CborMapData> * map_data_list);
+void updateProperty(PropertyContainer & prop_cont, CborStringView const & propertyName, unsigned long cloudChangeEventTime, bool const is_sync_message, CborMapDataList * map_data_list);
 String getPropertyNameByIdentifier(PropertyContainer & prop_cont, int propertyIdentifier);
 
 #endif /* ARDUINO_PROPERTY_CONTAINER_H_ */
\ No newline at end of file
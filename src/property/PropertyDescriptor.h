@@ -0,0 +1,161 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2024 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_PROPERTY_DESCRIPTOR_H_
+#define ARDUINO_PROPERTY_DESCRIPTOR_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "Property.h"
+
+/******************************************************************************
+   STRUCT DECLARATION
+ ******************************************************************************/
+
+/* Compile time description of a property of a thing. A thing whose schema is
+ * known when the sketch is compiled can describe all its properties in a
+ * constexpr table which is placed in flash and registered at once:
+ *
+ *   static constexpr PropertyDescriptor thing_properties[] =
+ *   {
+ *     describeProperty(temperature, "temperature", Permission::Read, 1).publishOnChange(0.5f),
+ *     describeProperty(led, "led", Permission::ReadWrite, 2).onUpdate(onLedChange),
+ *     describeProperty(alarm, "alarm", Permission::Read, 3).priority(Priority::High),
+ *   };
+ *   static_assert(hasUniquePropertyNames(thing_properties), "duplicate property name");
+ *
+ *   ArduinoCloud.addProperties(thing_properties);
+ *
+ * A descriptor refers to a Property: a primitive variable (bool, int, float,
+ * String...) is described through a wrapper declared next to it, e.g.
+ *
+ *   static int level;
+ *   static CloudWrapperInt level_property(level);
+ *   describeProperty(level_property, "level", Permission::ReadWrite, 4)
+ *
+ * The name is referenced in place, it has to outlive the property.
+ */
+struct PropertyDescriptor
+{
+  Property *         property;
+  char const *       name;
+  Permission         permission;
+  int                identifier;
+  UpdatePolicy       update_policy;
+  /* Minimum time between updates [ms] for UpdatePolicy::OnChange, update interval [s] for UpdatePolicy::TimeInterval */
+  unsigned long      update_parameter;
+  float              min_delta;
+  UpdateCallbackFunc update_callback;
+  OnSyncCallbackFunc sync_callback;
+  Priority           priority_class;
+
+  /* Composable configuration, mirroring the one of the Property class */
+  constexpr PropertyDescriptor publishOnChange(float const min_delta_property, unsigned long const min_time_between_updates_millis = Property::DEFAULT_MIN_TIME_BETWEEN_UPDATES_MILLIS) const {
+    return PropertyDescriptor{property, name, permission, identifier, UpdatePolicy::OnChange, min_time_between_updates_millis, min_delta_property, update_callback, sync_callback, priority_class};
+  }
+  constexpr PropertyDescriptor publishEvery(unsigned long const seconds) const {
+    return PropertyDescriptor{property, name, permission, identifier, UpdatePolicy::TimeInterval, seconds, min_delta, update_callback, sync_callback, priority_class};
+  }
+  constexpr PropertyDescriptor publishOnDemand() const {
+    return PropertyDescriptor{property, name, permission, identifier, UpdatePolicy::OnDemand, update_parameter, min_delta, update_callback, sync_callback, priority_class};
+  }
+  constexpr PropertyDescriptor onUpdate(UpdateCallbackFunc func) const {
+    return PropertyDescriptor{property, name, permission, identifier, update_policy, update_parameter, min_delta, func, sync_callback, priority_class};
+  }
+  constexpr PropertyDescriptor onSync(OnSyncCallbackFunc func) const {
+    return PropertyDescriptor{property, name, permission, identifier, update_policy, update_parameter, min_delta, update_callback, func, priority_class};
+  }
+  constexpr PropertyDescriptor priority(Priority const priority) const {
+    return PropertyDescriptor{property, name, permission, identifier, update_policy, update_parameter, min_delta, update_callback, sync_callback, priority};
+  }
+};
+
+/******************************************************************************
+   FUNCTION DEFINITION
+ ******************************************************************************/
+
+/* Describes a property published on change with the default rate limit */
+constexpr PropertyDescriptor describeProperty(Property & property, char const * name, Permission const permission, int const identifier = -1)
+{
+  return PropertyDescriptor{&property, name, permission, identifier, UpdatePolicy::OnChange, Property::DEFAULT_MIN_TIME_BETWEEN_UPDATES_MILLIS, 0.0f, nullptr, nullptr, Priority::Normal};
+}
+
+/* The following functions are evaluated at compile time when applied to a
+ * constexpr table: invalid tables are rejected by a static_assert and looking
+ * up a descriptor by name does not cost anything at runtime.
+ */
+
+namespace impl
+{
+
+constexpr bool isSameName(char const * lhs, char const * rhs)
+{
+  return (*lhs == *rhs) && ((*lhs == '\0') || isSameName(lhs + 1, rhs + 1));
+}
+
+constexpr bool isNameUsedAfter(PropertyDescriptor const * table, size_t const count, size_t const index, char const * name)
+{
+  return (index < count) && (isSameName(table[index].name, name) || isNameUsedAfter(table, count, index + 1, name));
+}
+
+constexpr bool isIdentifierUsedAfter(PropertyDescriptor const * table, size_t const count, size_t const index, int const identifier)
+{
+  return (identifier >= 0) && (index < count) && ((table[index].identifier == identifier) || isIdentifierUsedAfter(table, count, index + 1, identifier));
+}
+
+constexpr bool hasUniqueNames(PropertyDescriptor const * table, size_t const count, size_t const index)
+{
+  return (index >= count) || (!isNameUsedAfter(table, count, index + 1, table[index].name) && hasUniqueNames(table, count, index + 1));
+}
+
+constexpr bool hasUniqueIdentifiers(PropertyDescriptor const * table, size_t const count, size_t const index)
+{
+  return (index >= count) || (!isIdentifierUsedAfter(table, count, index + 1, table[index].identifier) && hasUniqueIdentifiers(table, count, index + 1));
+}
+
+constexpr int findByName(PropertyDescriptor const * table, size_t const count, size_t const index, char const * name)
+{
+  return (index >= count) ? -1 : (isSameName(table[index].name, name) ? static_cast<int>(index) : findByName(table, count, index + 1, name));
+}
+
+} /* impl */
+
+template <size_t N>
+constexpr bool hasUniquePropertyNames(PropertyDescriptor const (&table)[N])
+{
+  return impl::hasUniqueNames(table, N, 0);
+}
+
+/* Properties without identifier (-1) are not taken into account */
+template <size_t N>
+constexpr bool hasUniquePropertyIdentifiers(PropertyDescriptor const (&table)[N])
+{
+  return impl::hasUniqueIdentifiers(table, N, 0);
+}
+
+/* Returns the index of the descriptor with the given name or -1 */
+template <size_t N>
+constexpr int findPropertyDescriptor(PropertyDescriptor const (&table)[N], char const * name)
+{
+  return impl::findByName(table, N, 0, name);
+}
+
+#endif /* ARDUINO_PROPERTY_DESCRIPTOR_H_ */
@@ -48,6 +48,7 @@ class CloudString : public Property {
     }
     void clear() {
       _value = PropertyActions::CLEAR;
+      updateLocalTimestamp();
     }
     virtual bool isDifferentFromCloud() {
       return _value != _cloud_value;
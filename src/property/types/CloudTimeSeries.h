@@ -0,0 +1,162 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2024 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_CLOUD_TIME_SERIES_H_
+#define ARDUINO_CLOUD_TIME_SERIES_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include "../Property.h"
+#include "CloudBool.h"
+#include "CloudInt.h"
+#include "CloudUnsignedInt.h"
+#include "CloudFloat.h"
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+/* Property type recording values of type T */
+template <typename T> struct CloudTimeSeriesBase;
+template <> struct CloudTimeSeriesBase<bool>         { typedef CloudBool        type; };
+template <> struct CloudTimeSeriesBase<int>          { typedef CloudInt         type; };
+template <> struct CloudTimeSeriesBase<unsigned int> { typedef CloudUnsignedInt type; };
+template <> struct CloudTimeSeriesBase<float>        { typedef CloudFloat       type; };
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Property recording every value assigned to it, together with the time it
+ * was assigned, and sending all of them on the next update instead of the
+ * last value only. T is one of bool, int, unsigned int or float. Sampling at
+ * a high rate while publishing rarely:
+ *
+ *   CloudTimeSeries<float, 600> temperature;
+ *   ArduinoCloud.addProperty(temperature, Permission::Read).publishEvery(60);
+ *   ...
+ *   temperature = readTemperature(); // every 100 ms
+ *
+ * Samples are sent as a SenML pack, using base time and relative times when
+ * SenML base compression is enabled. When the buffer is full the oldest sample
+ * is overwritten, samples not fitting into the message are kept for the next
+ * update. Sample times have a resolution of 1 ms relative to each other, the
+ * time of the first sample of the buffer has a resolution of 1 s.
+ */
+template <typename T, size_t SAMPLES>
+class CloudTimeSeries : public CloudTimeSeriesBase<T>::type
+{
+  public:
+    typedef typename CloudTimeSeriesBase<T>::type CloudType;
+
+    CloudTimeSeries() : CloudType(T{}), _head{0}, _count{0}, _flush_count{0}, _reference_time{0}, _reference_millis{0} { }
+
+    CloudTimeSeries & operator=(T const v) {
+      CloudType::operator=(v);
+      return *this;
+    }
+
+    /* Records the current value on every local write, i.e. assignments as
+     * well as the compound assignment and increment operators of CloudType.
+     */
+    virtual void updateLocalTimestamp() override {
+      CloudType::updateLocalTimestamp();
+      unsigned long const now_millis = millis();
+      if (_count == 0) {
+        _reference_time = this->getLastLocalChangeTimestamp();
+        _reference_millis = now_millis;
+      }
+      if (_count == SAMPLES) {
+        _head = (_head + 1) % SAMPLES;
+        _count--;
+      }
+      _samples[(_head + _count) % SAMPLES] = Sample{now_millis - _reference_millis, static_cast<T>(*this)};
+      _count++;
+    }
+
+    inline size_t samples() const {
+      return _count;
+    }
+
+    /* Recorded samples are changes even if the last value equals the one sent */
+    virtual bool isDifferentFromCloud() override {
+      return (_count > 0) || CloudType::isDifferentFromCloud();
+    }
+
+    /* Every sample is sent, none is superseded by a newer one */
+    virtual bool keepsHistory() override {
+      return true;
+    }
+
+    /* The samples written by the last call to appendAttributesToCloud() have been sent */
+    virtual void fromLocalToCloud() override {
+      CloudType::fromLocalToCloud();
+      _head = (_head + _flush_count) % SAMPLES;
+      _count -= _flush_count;
+      _flush_count = 0;
+    }
+
+    virtual CborError appendAttributesToCloud(CborEncoder * encoder) override {
+      _flush_count = 0;
+      if (_count == 0) {
+        return CloudType::appendAttributesToCloud(encoder);
+      }
+
+      unsigned long const first_millis = _samples[_head].offset_millis;
+      unsigned long const base_time = _reference_time + first_millis / 1000;
+      unsigned long const base_millis = first_millis - (first_millis % 1000);
+
+      for (size_t i = 0; i < _count; i++)
+      {
+        Sample const & s = _samples[(_head + i) % SAMPLES];
+        float const time_offset = static_cast<float>(s.offset_millis - base_millis) / 1000.0f;
+
+        /* Append as many samples as fit into the message, leaving room for closing it */
+        CborEncoder const encoder_checkpoint = *encoder;
+        CborError error = this->appendSample(s.value, base_time, time_offset, (i == 0), encoder);
+        if ((error == CborNoError) && ((encoder->end - encoder->data.ptr) < 1)) {
+          error = CborErrorOutOfMemory;
+        }
+        if (error != CborNoError) {
+          *encoder = encoder_checkpoint;
+          return (i == 0) ? error : CborNoError;
+        }
+        _flush_count++;
+      }
+      return CborNoError;
+    }
+
+  private:
+    struct Sample
+    {
+      /* Time of the sample relative to _reference_millis */
+      unsigned long offset_millis;
+      T value;
+    };
+
+    Sample _samples[SAMPLES];
+    size_t _head,
+           _count,
+           _flush_count;
+    unsigned long _reference_time,
+                  _reference_millis;
+};
+
+#endif /* ARDUINO_CLOUD_TIME_SERIES_H_ */
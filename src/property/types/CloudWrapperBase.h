@@ -31,7 +31,9 @@
 
 class CloudWrapperBase : public Property {
   public:
+    /* The wrapped variable has been written since the last time it was observed */
     virtual bool isChangedLocally() = 0;
+    virtual void fromPrimitiveToLocal() = 0;
 };
 
 
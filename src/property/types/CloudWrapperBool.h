@@ -41,6 +41,7 @@ class CloudWrapperBool : public CloudWrapperBase {
     }
     virtual void fromCloudToLocal() {
       _primitive_value = _cloud_value;
+      _local_value = _cloud_value;
     }
     virtual void fromLocalToCloud() {
       _cloud_value = _primitive_value;
@@ -57,6 +58,9 @@ class CloudWrapperBool : public CloudWrapperBase {
     virtual bool isChangedLocally() {
       return _primitive_value != _local_value;
     }
+    virtual void fromPrimitiveToLocal() {
+      _local_value = _primitive_value;
+    }
 };
 
 
@@ -43,6 +43,7 @@ class CloudWrapperFloat : public CloudWrapperBase {
     }
     virtual void fromCloudToLocal() {
       _primitive_value = _cloud_value;
+      _local_value = _cloud_value;
     }
     virtual void fromLocalToCloud() {
       _cloud_value = _primitive_value;
@@ -59,6 +60,9 @@ class CloudWrapperFloat : public CloudWrapperBase {
     virtual bool isChangedLocally() {
       return _primitive_value != _local_value;
     }
+    virtual void fromPrimitiveToLocal() {
+      _local_value = _primitive_value;
+    }
 };
 
 
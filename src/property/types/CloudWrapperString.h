@@ -45,6 +45,7 @@ class CloudWrapperString : public CloudWrapperBase {
     }
     virtual void fromCloudToLocal() {
       _primitive_value = _cloud_value;
+      _local_value = _cloud_value;
     }
     virtual void fromLocalToCloud() {
       _cloud_value = _primitive_value;
@@ -61,6 +62,9 @@ class CloudWrapperString : public CloudWrapperBase {
     virtual bool isChangedLocally() {
       return _primitive_value != _local_value;
     }
+    virtual void fromPrimitiveToLocal() {
+      _local_value = _primitive_value;
+    }
 };
 
 
@@ -81,6 +81,7 @@ class CloudDimmedLight : public Property {
 
     void setBrightness(float const bri) {
       _value.bri = bri;
+      updateLocalTimestamp();
     }
 
     bool getSwitch() {
@@ -89,6 +90,7 @@ class CloudDimmedLight : public Property {
 
     void setSwitch(bool const swi) {
       _value.swi = swi;
+      updateLocalTimestamp();
     }
 
     virtual void fromCloudToLocal() {
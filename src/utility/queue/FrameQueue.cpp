@@ -0,0 +1,399 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2024 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "FrameQueue.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * RAMFrameQueueStorage
+ ******************************************************************************/
+
+RAMFrameQueueStorage::RAMFrameQueueStorage(uint8_t * buf, size_t const size)
+: _buf{buf}
+, _size{size}
+{
+  erase();
+}
+
+bool RAMFrameQueueStorage::read(size_t const offset, uint8_t * data, size_t const len)
+{
+  if ((offset > _size) || (len > (_size - offset)))
+    return false;
+
+  memcpy(data, _buf + offset, len);
+  return true;
+}
+
+bool RAMFrameQueueStorage::write(size_t const offset, uint8_t const * data, size_t const len)
+{
+  if ((offset > _size) || (len > (_size - offset)))
+    return false;
+
+  memcpy(_buf + offset, data, len);
+  return true;
+}
+
+void RAMFrameQueueStorage::erase()
+{
+  memset(_buf, 0xFF, _size);
+}
+
+bool RAMFrameQueueStorage::commitScratch(size_t const len)
+{
+  if (len > _size)
+    return false;
+
+  /* The entries have been copied in place, only the rest has to read as erased */
+  memset(_buf + len, 0xFF, _size - len);
+  return true;
+}
+
+/******************************************************************************
+ * FileFrameQueueStorage
+ ******************************************************************************/
+
+#if FRAME_QUEUE_HAS_FILE_STORAGE
+FileFrameQueueStorage::FileFrameQueueStorage(char const * path, char const * scratch_path, size_t const size)
+: _path{path}
+, _scratch_path{scratch_path}
+, _size{size}
+, _file{nullptr}
+, _scratch_file{nullptr}
+{
+
+}
+
+FileFrameQueueStorage::~FileFrameQueueStorage()
+{
+  close();
+}
+
+bool FileFrameQueueStorage::read(size_t const offset, uint8_t * data, size_t const len)
+{
+  if ((offset > _size) || (len > (_size - offset)) || !open())
+    return false;
+
+  if (fseek(_file, static_cast<long>(offset), SEEK_SET) != 0)
+    return false;
+
+  /* The file only grows up to the last byte written, the rest reads as erased */
+  size_t const bytes_read = fread(data, 1, len, _file);
+  memset(data + bytes_read, 0xFF, len - bytes_read);
+  return true;
+}
+
+bool FileFrameQueueStorage::write(size_t const offset, uint8_t const * data, size_t const len)
+{
+  if ((offset > _size) || (len > (_size - offset)) || !open())
+    return false;
+
+  if (fseek(_file, static_cast<long>(offset), SEEK_SET) != 0)
+    return false;
+
+  return (fwrite(data, 1, len, _file) == len) && (fflush(_file) == 0);
+}
+
+void FileFrameQueueStorage::erase()
+{
+  close();
+
+  /* Truncates the file */
+  _file = fopen(_path, "w+b");
+}
+
+bool FileFrameQueueStorage::beginScratch()
+{
+  if (_scratch_file != nullptr)
+    fclose(_scratch_file);
+
+  /* Left over by an interrupted compaction, if any, the scratch file is truncated */
+  _scratch_file = fopen(_scratch_path, "w+b");
+  return (_scratch_file != nullptr);
+}
+
+bool FileFrameQueueStorage::writeScratch(size_t const offset, uint8_t const * data, size_t const len)
+{
+  if ((_scratch_file == nullptr) || (offset > _size) || (len > (_size - offset)))
+    return false;
+
+  if (fseek(_scratch_file, static_cast<long>(offset), SEEK_SET) != 0)
+    return false;
+
+  return (fwrite(data, 1, len, _scratch_file) == len);
+}
+
+bool FileFrameQueueStorage::commitScratch(size_t const len)
+{
+  if ((_scratch_file == nullptr) || (len > _size))
+    return false;
+
+  bool const flushed = (fflush(_scratch_file) == 0);
+  fclose(_scratch_file);
+  _scratch_file = nullptr;
+  if (!flushed)
+    return false;
+
+  /* The file holds either the entries before or after the compaction at any time.
+   * File systems which cannot rename over an existing file leave the scratch file
+   * alone for a moment, open() completes the rename after a reset.
+   */
+  if (_file != nullptr) {
+    fclose(_file);
+    _file = nullptr;
+  }
+  if ((rename(_scratch_path, _path) != 0) && ((remove(_path) != 0) || (rename(_scratch_path, _path) != 0)))
+    return false;
+
+  return open();
+}
+
+bool FileFrameQueueStorage::open()
+{
+  if (_file == nullptr)
+    _file = fopen(_path, "r+b");
+  if ((_file == nullptr) && (rename(_scratch_path, _path) == 0))
+    _file = fopen(_path, "r+b");
+  if (_file == nullptr)
+    _file = fopen(_path, "w+b");
+  return (_file != nullptr);
+}
+
+void FileFrameQueueStorage::close()
+{
+  if (_file != nullptr) {
+    fclose(_file);
+    _file = nullptr;
+  }
+  if (_scratch_file != nullptr) {
+    fclose(_scratch_file);
+    _scratch_file = nullptr;
+  }
+}
+#endif /* FRAME_QUEUE_HAS_FILE_STORAGE */
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+FrameQueue::FrameQueue()
+: _storage{nullptr}
+, _read_offset{0}
+, _write_offset{0}
+, _pending{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void FrameQueue::begin(FrameQueueStorage * storage)
+{
+  _storage = storage;
+  _read_offset = 0;
+  _write_offset = 0;
+  _pending = 0;
+
+  if (_storage == nullptr)
+    return;
+
+  /* Walk the stored entries up to the first erased byte */
+  EntryHeader header;
+  bool read_offset_found = false;
+  while (readHeader(_write_offset, header) && (header.length != 0xFFFF || header.state != Erased))
+  {
+    if ((ENTRY_HEADER_SIZE + header.length) > (_storage->capacity() - _write_offset))
+      break;
+
+    if (header.state == Erased) {
+      /* Interrupted while being written */
+      markDone(_write_offset);
+    } else if (header.state == Pending) {
+      if (!read_offset_found) {
+        _read_offset = _write_offset;
+        read_offset_found = true;
+      }
+      _pending++;
+    }
+    _write_offset += ENTRY_HEADER_SIZE + header.length;
+  }
+
+  skipDone();
+}
+
+bool FrameQueue::push(int32_t const key, uint8_t const * data, size_t const len, bool const supersede)
+{
+  if ((_storage == nullptr) || (len > MAX_ENTRY_SIZE))
+    return false;
+
+  if (supersede)
+  {
+    EntryHeader header;
+    for (size_t offset = _read_offset; (offset < _write_offset) && readHeader(offset, header); offset += ENTRY_HEADER_SIZE + header.length)
+    {
+      if ((header.state == Pending) && (header.key == key)) {
+        markDone(offset);
+        _pending--;
+      }
+    }
+    skipDone();
+  }
+
+  if (((ENTRY_HEADER_SIZE + len) > (_storage->capacity() - _write_offset)) &&
+      (!compact() || ((ENTRY_HEADER_SIZE + len) > (_storage->capacity() - _write_offset))))
+    return false;
+
+  uint32_t const ukey = static_cast<uint32_t>(key);
+  uint8_t const header[ENTRY_HEADER_SIZE] =
+  {
+    Erased, 0xFF,
+    static_cast<uint8_t>(len), static_cast<uint8_t>(len >> 8),
+    static_cast<uint8_t>(ukey), static_cast<uint8_t>(ukey >> 8), static_cast<uint8_t>(ukey >> 16), static_cast<uint8_t>(ukey >> 24)
+  };
+  uint8_t const state = Pending;
+
+  if (!_storage->write(_write_offset, header, sizeof(header)) ||
+      !_storage->write(_write_offset + ENTRY_HEADER_SIZE, data, len) ||
+      !_storage->write(_write_offset, &state, sizeof(state)))
+    return false;
+
+  if (_pending == 0)
+    _read_offset = _write_offset;
+  _write_offset += ENTRY_HEADER_SIZE + len;
+  _pending++;
+  skipDone();
+  return true;
+}
+
+size_t FrameQueue::peek(uint8_t * data, size_t const size, size_t & entries)
+{
+  size_t bytes_copied = 0;
+  entries = 0;
+
+  EntryHeader header;
+  for (size_t offset = _read_offset; (offset < _write_offset) && readHeader(offset, header); offset += ENTRY_HEADER_SIZE + header.length)
+  {
+    if (header.state != Pending)
+      continue;
+    if (header.length > (size - bytes_copied))
+      break;
+    if (!_storage->read(offset + ENTRY_HEADER_SIZE, data + bytes_copied, header.length))
+      break;
+
+    bytes_copied += header.length;
+    entries++;
+  }
+
+  return bytes_copied;
+}
+
+void FrameQueue::pop(size_t entries, std::function<void(int32_t const key)> popped)
+{
+  EntryHeader header;
+  for (size_t offset = _read_offset; (entries > 0) && (offset < _write_offset) && readHeader(offset, header); offset += ENTRY_HEADER_SIZE + header.length)
+  {
+    if (header.state == Pending) {
+      markDone(offset);
+      _pending--;
+      entries--;
+      if (popped)
+        popped(header.key);
+    }
+  }
+
+  skipDone();
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool FrameQueue::readHeader(size_t const offset, EntryHeader & header)
+{
+  uint8_t buf[ENTRY_HEADER_SIZE];
+  if ((offset + ENTRY_HEADER_SIZE) > _storage->capacity() || !_storage->read(offset, buf, sizeof(buf)))
+    return false;
+
+  header.state  = buf[0];
+  header.length = static_cast<size_t>(buf[2]) | (static_cast<size_t>(buf[3]) << 8);
+  header.key    = static_cast<int32_t>(static_cast<uint32_t>(buf[4])         | (static_cast<uint32_t>(buf[5]) << 8) |
+                                       (static_cast<uint32_t>(buf[6]) << 16) | (static_cast<uint32_t>(buf[7]) << 24));
+  return true;
+}
+
+void FrameQueue::markDone(size_t const offset)
+{
+  uint8_t const state = Done;
+  _storage->write(offset, &state, sizeof(state));
+}
+
+void FrameQueue::skipDone()
+{
+  /* The space of the sent entries is only reclaimed once needed, by compact() */
+  EntryHeader header;
+  while ((_read_offset < _write_offset) && readHeader(_read_offset, header) && (header.state != Pending))
+    _read_offset += ENTRY_HEADER_SIZE + header.length;
+}
+
+bool FrameQueue::compact()
+{
+  /* Once every entry has been sent the whole storage is reclaimed */
+  if (_pending == 0) {
+    _storage->erase();
+    _read_offset = 0;
+    _write_offset = 0;
+    return true;
+  }
+
+  /* The pending entries are copied to the scratch area, which replaces the
+   * content of the storage only once complete: an interruption leaves the
+   * storage as it was, until then the queue keeps using it as is.
+   */
+  if (!_storage->beginScratch())
+    return false;
+
+  size_t compacted_offset = 0;
+  EntryHeader header;
+  for (size_t offset = _read_offset; (offset < _write_offset) && readHeader(offset, header); offset += ENTRY_HEADER_SIZE + header.length)
+  {
+    if (header.state != Pending)
+      continue;
+
+    uint8_t buf[64];
+    size_t const entry_size = ENTRY_HEADER_SIZE + header.length;
+    for (size_t copied = 0; copied < entry_size; copied += sizeof(buf))
+    {
+      size_t const chunk = ((entry_size - copied) < sizeof(buf)) ? (entry_size - copied) : sizeof(buf);
+      if (!_storage->read(offset + copied, buf, chunk) || !_storage->writeScratch(compacted_offset + copied, buf, chunk))
+        return false;
+    }
+    compacted_offset += entry_size;
+  }
+
+  if ((compacted_offset == _write_offset) || !_storage->commitScratch(compacted_offset))
+    return false;
+
+  _read_offset = 0;
+  _write_offset = compacted_offset;
+  return true;
+}
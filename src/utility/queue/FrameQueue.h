@@ -0,0 +1,184 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2024 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_FRAME_QUEUE_H_
+#define ARDUINO_IOT_CLOUD_FRAME_QUEUE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+
+#if defined(HOST) || defined(ARDUINO_ARCH_MBED) || defined(ARDUINO_ARCH_ESP32)
+  #include <stdio.h>
+  #define FRAME_QUEUE_HAS_FILE_STORAGE 1
+#endif
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Backing storage of a FrameQueue. Entries are only appended and their state
+ * byte is only ever changed by clearing bits, hence flash memory can be used
+ * as long as erase() restores every byte to 0xFF. Storage supporting the
+ * compaction of the queue provides a scratch area: the pending entries are
+ * copied to it starting from offset 0, then commitScratch() replaces the
+ * content of the storage with the len bytes written to it at once.
+ */
+class FrameQueueStorage
+{
+public:
+  virtual ~FrameQueueStorage() { }
+
+  virtual size_t capacity() = 0;
+  /* Bytes never written since the last erase() read as 0xFF */
+  virtual bool read(size_t const offset, uint8_t * data, size_t const len) = 0;
+  virtual bool write(size_t const offset, uint8_t const * data, size_t const len) = 0;
+  virtual void erase() = 0;
+  virtual bool beginScratch() { return false; }
+  virtual bool writeScratch(size_t const offset, uint8_t const * data, size_t const len) { (void)offset; (void)data; (void)len; return false; }
+  virtual bool commitScratch(size_t const len) { (void)len; return false; }
+};
+
+/* Storage in a caller provided RAM buffer, lost on reset. The scratch area is
+ * the buffer itself: entries are only ever copied to lower offsets.
+ */
+class RAMFrameQueueStorage : public FrameQueueStorage
+{
+public:
+  RAMFrameQueueStorage(uint8_t * buf, size_t const size);
+
+  virtual size_t capacity() override { return _size; }
+  virtual bool read(size_t const offset, uint8_t * data, size_t const len) override;
+  virtual bool write(size_t const offset, uint8_t const * data, size_t const len) override;
+  virtual void erase() override;
+  virtual bool beginScratch() override { return true; }
+  virtual bool writeScratch(size_t const offset, uint8_t const * data, size_t const len) override { return write(offset, data, len); }
+  virtual bool commitScratch(size_t const len) override;
+
+private:
+  uint8_t * _buf;
+  size_t _size;
+};
+
+#if FRAME_QUEUE_HAS_FILE_STORAGE
+/* Storage in a file of a file system mounted by the sketch, e.g. LittleFS
+ * mounted as "/fs" on mbed boards or "/littlefs" on ESP32, surviving a reset.
+ * The scratch area is a second file on the same file system, renamed over the
+ * first one on commit, so that a reset during a compaction leaves either the
+ * entries before or after it.
+ */
+class FileFrameQueueStorage : public FrameQueueStorage
+{
+public:
+  FileFrameQueueStorage(char const * path, char const * scratch_path, size_t const size);
+  virtual ~FileFrameQueueStorage();
+
+  virtual size_t capacity() override { return _size; }
+  virtual bool read(size_t const offset, uint8_t * data, size_t const len) override;
+  virtual bool write(size_t const offset, uint8_t const * data, size_t const len) override;
+  virtual void erase() override;
+  virtual bool beginScratch() override;
+  virtual bool writeScratch(size_t const offset, uint8_t const * data, size_t const len) override;
+  virtual bool commitScratch(size_t const len) override;
+
+private:
+  char const * _path;
+  char const * _scratch_path;
+  size_t _size;
+  FILE * _file;
+  FILE * _scratch_file;
+
+  bool open();
+  void close();
+};
+#endif /* FRAME_QUEUE_HAS_FILE_STORAGE */
+
+/* Bounded append-only queue of encoded property records, used to store the
+ * property updates produced while the connection to the cloud is down and to
+ * send them once it is up again. Every entry carries a key, the identifier of
+ * the property, so that a value can supersede the values of the same property
+ * still waiting in the queue.
+ *
+ * Entry layout: state (1 byte), reserved (1 byte), length (2 bytes), key (4 bytes),
+ * followed by length bytes of data. The state is written last, an entry whose
+ * write has been interrupted is discarded when the queue is recovered by begin().
+ * Space is reclaimed once the end of the storage is reached: the storage is
+ * erased if all the entries have been sent, otherwise the pending entries are
+ * compacted through the scratch area if the storage provides one, dropping the
+ * sent and superseded ones.
+ */
+class FrameQueue
+{
+public:
+  FrameQueue();
+
+  /* Attaches the storage and recovers the entries stored by a previous run */
+  void begin(FrameQueueStorage * storage);
+
+  /* Appends an entry, returns false if the queue is full. If supersede is true
+   * the entries with the same key still waiting in the queue are dropped.
+   */
+  bool push(int32_t const key, uint8_t const * data, size_t const len, bool const supersede);
+  /* Copies the data of the oldest entries into data, as many as fit into size
+   * bytes, and returns the number of bytes copied. The number of entries copied
+   * is returned in entries, entries are not removed until pop() is called.
+   */
+  size_t peek(uint8_t * data, size_t const size, size_t & entries);
+  /* Removes the oldest entries from the queue, passing the key of each one to
+   * popped if provided.
+   */
+  void pop(size_t entries, std::function<void(int32_t const key)> popped = nullptr);
+
+  inline bool   isEnabled() const { return _storage != nullptr; }
+  inline bool   empty()     const { return _pending == 0; }
+  inline size_t pending()   const { return _pending; }
+
+  static size_t const ENTRY_HEADER_SIZE = 8;
+  static size_t const MAX_ENTRY_SIZE = 0xFFFF;
+
+private:
+  enum EntryState : uint8_t
+  {
+    Erased  = 0xFF,
+    Pending = 0x7F,
+    Done    = 0x3F,
+  };
+
+  struct EntryHeader
+  {
+    uint8_t state;
+    size_t  length;
+    int32_t key;
+  };
+
+  FrameQueueStorage * _storage;
+  size_t _read_offset;
+  size_t _write_offset;
+  size_t _pending;
+
+  bool readHeader(size_t const offset, EntryHeader & header);
+  void markDone(size_t const offset);
+  void skipDone();
+  bool compact();
+};
+
+#endif /* ARDUINO_IOT_CLOUD_FRAME_QUEUE_H_ */